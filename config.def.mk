@@ -10,6 +10,12 @@ VERSIONPOS=suffix
 CC=cc
 CFLAGS?=-fPIC -O3 -ffast-math -freciprocal-math -fno-trapping-math \
 	-mfpmath=sse,387 -mpc32
+# Uncomment to use the approximations in sonicmaths/fastmath.h instead of
+# libm: 1 for about float precision, 2 for shorter polynomials.
+#CFLAGS+=-DSMFASTMATH=1
+# Uncomment to ramp modulated filter cutoffs between exact values every K
+# samples (see sonicmaths/filter.h).
+#CFLAGS+=-DSMFINTERP=8
 LDFLAGS?=
 AR?=ar
 ARFLAGS?=rv
@@ -18,5 +24,5 @@ CFLAGS+=-Wall -Wextra -Wmissing-prototypes -Wredundant-decls \
 	-Wdouble-promotion
 CFLAGS+=-Iinclude
 
-LIBS=-lm
-STATIC=-lm
+LIBS=-lm -lpthread
+STATIC=-lm -lpthread
@@ -23,12 +23,20 @@
 #ifndef SONICMATHS_H
 #define SONICMATHS_H 1
 
+#include <sonicmaths/additive.h>
+#include <sonicmaths/band-limited.h>
 #include <sonicmaths/clock.h>
 #include <sonicmaths/cosine.h>
+#include <sonicmaths/crossover.h>
 #include <sonicmaths/delay.h>
 #include <sonicmaths/differentiator.h>
 #include <sonicmaths/envelope-generator.h>
+#include <sonicmaths/fastmath.h>
 #include <sonicmaths/fdmodulator.h>
+#include <sonicmaths/fm.h>
+#include <sonicmaths/filter.h>
+#include <sonicmaths/filter-bank.h>
+#include <sonicmaths/granular.h>
 #include <sonicmaths/highpass2.h>
 #include <sonicmaths/impulse-train.h>
 #include <sonicmaths/integrator.h>
@@ -36,10 +44,17 @@
 #include <sonicmaths/lag.h>
 #include <sonicmaths/limit.h>
 #include <sonicmaths/math.h>
+#include <sonicmaths/minblep.h>
+#include <sonicmaths/modal.h>
+#include <sonicmaths/multiband.h>
 #include <sonicmaths/oscillator.h>
+#include <sonicmaths/phaser.h>
 #include <sonicmaths/quantize.h>
 #include <sonicmaths/random.h>
 #include <sonicmaths/reverb.h>
 #include <sonicmaths/sample-and-hold.h>
+#include <sonicmaths/strings.h>
+#include <sonicmaths/vector.h>
+#include <sonicmaths/wavetable.h>
 
 #endif /* ! SONICMATHS_H */
@@ -0,0 +1,63 @@
+/** @file additive.h
+ *
+ * Additive oscillator: a bank of cosine partials summed into one output.
+ *
+ * The phases, frequency ratios and amplitudes of the partials are each kept
+ * in one array, and the partials are advanced SMV_WIDTH at a time with the
+ * fixed-point phase of smcosq(). A partial whose frequency is not below
+ * Nyquist is silent for as long as it stays there.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_ADDITIVE_H
+#define SONICMATHS_ADDITIVE_H 1
+
+#include <stdint.h>
+
+/**
+ * Additive oscillator
+ *
+ * The arrays are padded to a multiple of SMV_WIDTH; ratio and amp may be
+ * changed freely between calls for partials 0 to npartials - 1.
+ */
+struct smadditive {
+	int npartials; /** The number of partials */
+	uint32_t *t; /** The phase of each partial, in 2^-32 cycles */
+	float *ratio; /** The frequency of each partial, as a multiple of f */
+	float *amp; /** The amplitude of each partial */
+};
+
+/**
+ * Initialize additive oscillator
+ *
+ * The partials start out harmonic, silent, and in phase.
+ */
+int smadditive_init(struct smadditive *add, int npartials);
+
+/**
+ * Destroy additive oscillator
+ */
+void smadditive_destroy(struct smadditive *add);
+
+/**
+ * Sum of amp[k] cos(2 pi ratio[k] f t) over the partials below Nyquist.
+ */
+void smadditive(struct smadditive *add, int n, float *y, float *f);
+
+#endif /* ! SONICMATHS_ADDITIVE_H */
@@ -0,0 +1,91 @@
+/** @file band-limited.h
+ *
+ * Band-limited sawtooth, square, pulse and triangle waves.
+ *
+ * Each is an impulse train, as in impulse-train.h, run through the
+ * integrator of integrator.h. While any parameter is modulated, the trains
+ * are evaluated and integrated in one loop over the block. While they are
+ * all constant, the loops are not fused: smitrain() renders the trains 64
+ * samples at a time into buffers on the stack, and these are integrated
+ * afterwards.
+ *
+ * The square and pulse integrate the difference of two trains, and the
+ * triangle integrates the square a second time. The trains are scaled by 4f
+ * before each integration, which gives the sawtooth and square a height of
+ * 2 and the triangle a peak of 1. The integrator adds a delay of 3 samples
+ * at each stage.
+ *
+ * On the first call, the integrators are set to the state they would have
+ * if the wave had always been running at the starting phase, f and w, so
+ * that there is no startup transient. A leaky integrator would otherwise
+ * take thousands of samples to forget a start from zero. Between the
+ * triangle's two integrators, a DC blocker keeps the second from magnifying
+ * whatever DC the first passes on.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_BAND_LIMITED_H
+#define SONICMATHS_BAND_LIMITED_H 1
+
+#include <sonicmaths/oscillator.h>
+#include <sonicmaths/integrator.h>
+
+/**
+ * Band-limited oscillator
+ */
+struct smblosc {
+	struct smosc osc; /** The phase */
+	struct smintg intg[2]; /** The integrators */
+	float dc[2]; /** The DC blocker between the triangle's integrators */
+	int seeded; /** Whether the state has been seeded */
+};
+
+/**
+ * Initialize band-limited oscillator
+ */
+int smblosc_init(struct smblosc *bl);
+
+/**
+ * Destroy band-limited oscillator
+ */
+void smblosc_destroy(struct smblosc *bl);
+
+/**
+ * Sawtooth, falling from 1 to -1 over each cycle.
+ */
+void smsaw(struct smblosc *bl, int n, float *y, float *f, float *phi);
+
+/**
+ * Square, 1 for the first half of each cycle and -1 for the second.
+ */
+void smsquare(struct smblosc *bl, int n, float *y, float *f, float *phi);
+
+/**
+ * Pulse, high for the fraction w of each cycle. The jump is 2, and the wave
+ * has no DC.
+ */
+void smpulse(struct smblosc *bl, int n, float *y, float *f, float *phi,
+	     float *w);
+
+/**
+ * Triangle, rising from -1 to 1 over the first half of each cycle.
+ */
+void smtriangle(struct smblosc *bl, int n, float *y, float *f, float *phi);
+
+#endif /* ! SONICMATHS_BAND_LIMITED_H */
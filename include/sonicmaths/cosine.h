@@ -23,8 +23,53 @@
 #ifndef SONICMATHS_COSINE_H
 #define SONICMATHS_COSINE_H 1
 
+#include <stdint.h>
 #include <sonicmaths/oscillator.h>
+#include <sonicmaths/vector.h>
 
 void smcos(struct smosc *osc, int n, float *y, float *f, float *phi);
 
+/*
+ * cos(2 pi t 2^-32) by a degree 9 polynomial. The polynomial is good to
+ * 3e-9; the measured error in float is 2e-7. With x the phase as a signed
+ * integer, |x| - 2^30 is a quarter cycle either side of the zero crossing,
+ * where cos is minus an odd function.
+ */
+#define SMCOSQ_P(u, u2)							\
+	((u) * (-6.283185160e+00f + (u2) * (4.134165503e+01f		\
+	 + (u2) * (-8.160100373e+01f + (u2) * (7.654977527e+01f	\
+	 + (u2) * -3.953665710e+01f)))))
+
+static inline float smcosqv(uint32_t t) {
+	int32_t x, s;
+	float u;
+	x = (int32_t) t;
+	s = x >> 31;
+	u = (float) ((x ^ s) - (1 << 30) - s) * (1.0f / 4294967296.0f);
+	return SMCOSQ_P(u, u * u);
+}
+
+static inline smvf smvcosq(smvi x) {
+	smvi s;
+	smvf u;
+	s = x >> 31;
+	u = __builtin_convertvector((x ^ s) - (1 << 30) - s, smvf)
+	    * (1.0f / 4294967296.0f);
+	return SMCOSQ_P(u, u * u);
+}
+
+/**
+ * smphasorinc() for each lane, for any x: whole cycles are dropped first.
+ */
+static inline smvu smvphasorinc(smvf x) {
+	x -= __builtin_convertvector(smvround(x), smvf);
+	return (smvu) __builtin_convertvector(x * 2147483648.0f, smvi) << 1;
+}
+
+/**
+ * Cosine with a fixed-point phase. Like smcos(), but f and phi must be less
+ * than 1 in magnitude.
+ */
+void smcosq(struct smphasor *ph, int n, float *y, float *f, float *phi);
+
 #endif /* ! SONICMATHS_COSINE_H */
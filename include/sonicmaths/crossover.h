@@ -0,0 +1,62 @@
+/** @file crossover.h
+ *
+ * Linkwitz-Riley crossover, splitting a signal into bands of equal width.
+ *
+ * This does the same as smf4split(), but keeps the prewarped frequency of
+ * each crossover point from one block to the next for as long as the
+ * bandwidth stays the same, and processes one band over the whole block
+ * before moving on to the next.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_CROSSOVER_H
+#define SONICMATHS_CROSSOVER_H 1
+
+/**
+ * Crossover
+ */
+struct smxover {
+	int maxnbands; /** The maximum number of crossover points */
+	int nbands; /** The number of crossover points for bw */
+	float bw; /** The bandwidth w_2 was calculated for */
+	float *u; /** The filter state, 6 per crossover point */
+	float *w_2; /** The prewarped frequency of each crossover point */
+};
+
+/**
+ * Initialize crossover
+ */
+int smxover_init(struct smxover *xover, int maxnbands);
+
+/**
+ * Destroy crossover
+ */
+void smxover_destroy(struct smxover *xover);
+
+/**
+ * Split x into bands bw wide.
+ *
+ * The crossover points are at bw, 2 bw, ..., up to the Nyquist frequency or
+ * the maximum number of crossover points, whichever comes first. y[0] gets
+ * the lowest band and y[nbands] the highest, so y must have maxnbands + 1
+ * buffers.
+ */
+void smxover(struct smxover *xover, int n, float **y, float *x, float *bw);
+
+#endif /* ! SONICMATHS_CROSSOVER_H */
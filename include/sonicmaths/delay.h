@@ -2,6 +2,17 @@
  *
  * Delay filter.h
  *
+ * The length of a delay is rounded up to a power of two, so that the
+ * buffer is indexed with a mask. A mirrored delay maps the same memory
+ * twice in a row, so that x[j] and x[j + len] are the same sample, and a
+ * read of up to len samples starting anywhere in the buffer never wraps.
+ *
+ * Fractional delays are interpolated linearly unless another method is
+ * chosen with smdelay_set_interp(). The higher order methods read samples
+ * on both sides of the delay, and so need a delay of at least 1, or 2 for
+ * SMDELAY_LAGRANGE6, to stay causal. SMDELAY_ALLPASS keeps the gain flat
+ * at every frequency but, being recursive, smears sudden changes in delay;
+ * it needs a delay of at least 0.5.
  */
 /*
  * Copyright 2015 Evan Buswell
@@ -23,10 +34,27 @@
 #ifndef SONICMATHS_DELAY_H
 #define SONICMATHS_DELAY_H 1
 
+#include <stddef.h>
+
+/**
+ * Interpolation method
+ */
+enum smdelay_interp {
+	SMDELAY_LINEAR = 0, /** Between the two nearest samples */
+	SMDELAY_HERMITE, /** Cubic Hermite through the four nearest */
+	SMDELAY_LAGRANGE4, /** Lagrange through the four nearest */
+	SMDELAY_LAGRANGE6, /** Lagrange through the six nearest */
+	SMDELAY_ALLPASS /** First order allpass */
+};
+
 struct smdelay {
-	int len;
-	int i;
-	float *x;
+	int len; /** The length of the buffer, a power of two */
+	int i; /** The write position */
+	float *x; /** The buffer */
+	size_t mapsize; /** The size of each mapping if mirrored, or 0 */
+	enum smdelay_interp interp; /** The interpolation method */
+	int ntaps; /** The number of taps with allpass state */
+	float *y1; /** The allpass state of each tap */
 };
 
 /**
@@ -35,10 +63,29 @@ struct smdelay {
 void smdelay_destroy(struct smdelay *delay);
 
 /**
- * Initialize delay
+ * Initialize delay, with room for at least len samples
  */
 int smdelay_init(struct smdelay *delay, int len);
 
+/**
+ * Initialize mirrored delay, with room for at least len samples
+ */
+int smdelay_init_mirrored(struct smdelay *delay, int len);
+
+/**
+ * Choose the interpolation method. For SMDELAY_ALLPASS, ntaps is the most
+ * taps that will be read at once; further taps are interpolated linearly.
+ */
+int smdelay_set_interp(struct smdelay *delay, enum smdelay_interp interp,
+		       int ntaps);
+
+/**
+ * Delay x by each of the ntaps delays t[j], into y[j].
+ *
+ * The block of input is written first and each tap is then rendered over
+ * the whole block, reading contiguously where its delay is constant over
+ * the block.
+ */
 void smtapdelay(struct smdelay *delay, int n, int ntaps, float **y, float *x,
 		float **t);
 
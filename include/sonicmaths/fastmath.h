@@ -0,0 +1,499 @@
+/** @file fastmath.h
+ *
+ * Polynomial approximations of the transcendental functions used in the
+ * per-sample code, in scalar and vector form.
+ *
+ * The functions named smfast*v and smvfast* are always the approximations.
+ * The functions named sm*v and smv* (smtanv(), smvtan(), etc.) are what the
+ * library itself calls; they are the approximations if SMFASTMATH is
+ * defined to a nonzero value when compiling, and the libm functions
+ * otherwise. Code including these headers should be compiled with the same
+ * setting as the library.
+ *
+ * With SMFASTMATH=1 (or when SMFASTMATH is 0 or undefined, for the smfast*
+ * functions), the approximations are accurate to about float precision.
+ * With SMFASTMATH=2, shorter polynomials are used. The largest errors,
+ * measured against double precision over every float in the domain (over
+ * random arguments for pow), and rounded up, are:
+ *
+ * @verbatim
+function  domain            SMFASTMATH=1  SMFASTMATH=2
+tan       |x| < 1.5         2.8e-7 rel    3.8e-6 rel
+sin, cos  |x| < 8192        9.4e-8 abs    1.4e-6 abs
+exp2      [-126, 127]       1.2e-7 rel    3.0e-6 rel
+log2      positive normals  1.0e-7 (a)    6.4e-7 (a)
+log       positive normals  1.7e-7 (a)    4.9e-7 (a)
+exp       [-87, 88]         1.2e-7 (b)    2.5e-6 (b)
+pow       x >= 0            1.4e-7 (b)    2.7e-6 (b)
+atan      all               2.2e-7 abs    4.5e-7 abs
+
+(a) absolute, divided by max(1, |result|)
+(b) relative, divided by 1 + |log2(result)|
+@endverbatim
+ *
+ * These were measured with the CFLAGS in config.def.mk. tan loses relative
+ * accuracy towards its poles; smff2w_2() only uses it on [0, 1.01]. exp2
+ * clamps its argument to [-126, 127.49], so very negative arguments give
+ * 2^-126 rather than 0. Arguments outside the domains above, infinities and
+ * NaNs are not handled.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_FASTMATH_H
+#define SONICMATHS_FASTMATH_H 1
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <sonicmaths/vector.h>
+
+#ifndef SMFASTMATH
+# define SMFASTMATH 0
+#endif
+
+/* pi/2 split into three parts for argument reduction */
+#define SMFM_PIO2_1 1.5703125f
+#define SMFM_PIO2_2 4.837512969970703125e-4f
+#define SMFM_PIO2_3 7.54978995489188216e-8f
+
+/*
+ * Keep the compiler from reassociating the argument reduction, which
+ * -ffast-math would otherwise allow it to fold back into a single, inexact
+ * multiplication by pi/2.
+ */
+#if defined(__i386__) || defined(__x86_64__)
+# define SMFM_OPAQUE(x) __asm__("" : "+x" (x))
+#elif defined(__aarch64__)
+# define SMFM_OPAQUE(x) __asm__("" : "+w" (x))
+#else
+# define SMFM_OPAQUE(x) __asm__("" : "+m" (x))
+#endif
+
+#define SMFM_SQRT2 1.414213562373095f
+#define SMFM_LOG2E 1.442695040888963f
+#define SMFM_LN2 0.6931471805599453f
+#define SMFM_TANPI_8 0.4142135623730950f
+#define SMFM_TAN3PI_8 2.414213562373095f
+
+/*
+ * The polynomials, in terms of the reduced argument r and z = r * r:
+ *
+ * sin r = r + r z SINP(z), on [-pi/4, pi/4]
+ * cos r = 1 - z/2 + z^2 COSP(z), on [-pi/4, pi/4]
+ * tan r = r + r z TANP(z), on [-pi/4, pi/4]
+ * 2^r = 1 + r EXP2P(r), on [-1/2, 1/2]
+ * log(1 + r) = r - z/2 + r z LOGP(r), on [sqrt(1/2) - 1, sqrt(2) - 1]
+ * atan r = r + r z ATANP(z), on [-tan(pi/8), tan(pi/8)]
+ */
+#if SMFASTMATH >= 2
+# define SMFM_SINP(z) (0.008163282f * (z) - 0.1666339f)
+# define SMFM_COSP(z) (-0.001365245f * (z) + 0.04166128f)
+# define SMFM_TANP(z)							\
+	(((0.04308806f * (z) + 0.04139944f) * (z) + 0.1360647f) * (z)	\
+	 + 0.3331544f)
+# define SMFM_EXP2P(r)							\
+	(((0.009582844f * (r) + 0.05590644f) * (r) + 0.2402410f) * (r)	\
+	 + 0.6931242f)
+# define SMFM_LOGP(r)							\
+	((((0.1170770f * (r) - 0.1849688f) * (r) + 0.2049387f) * (r)	\
+	  - 0.2493687f) * (r) + 0.3331743f)
+# define SMFM_ATANP(z) ((-0.1122517f * (z) + 0.1971414f) * (z) - 0.3332551f)
+#else
+# define SMFM_SINP(z)							\
+	((-1.9515295891e-4f * (z) + 8.3321608736e-3f) * (z)		\
+	 - 1.6666654611e-1f)
+# define SMFM_COSP(z)							\
+	((2.443315711809948e-5f * (z) - 1.388731625493765e-3f) * (z)	\
+	 + 4.166664568298827e-2f)
+# define SMFM_TANP(z)							\
+	(((((9.38540185543e-3f * (z) + 3.11992232697e-3f) * (z)		\
+	   + 2.44301354525e-2f) * (z) + 5.34112807005e-2f) * (z)	\
+	 + 1.33387994085e-1f) * (z) + 3.33331568548e-1f)
+# define SMFM_EXP2P(r)							\
+	(((((1.535336188319500e-4f * (r) + 1.339887440266574e-3f) * (r)	\
+	    + 9.618437357674640e-3f) * (r) + 5.550332471162809e-2f)	\
+	  * (r) + 2.402264791363012e-1f) * (r) + 6.931472028550421e-1f)
+# define SMFM_LOGP(r)							\
+	((((((((7.0376836292e-2f * (r) - 1.1514610310e-1f) * (r)	\
+	      + 1.1676998740e-1f) * (r) - 1.2420140846e-1f) * (r)	\
+	    + 1.4249322787e-1f) * (r) - 1.6668057665e-1f) * (r)		\
+	  + 2.0000714765e-1f) * (r) - 2.4999993993e-1f) * (r)		\
+	 + 3.3333331174e-1f)
+# define SMFM_ATANP(z)							\
+	(((8.05374449538e-2f * (z) - 1.38776856032e-1f) * (z)		\
+	  + 1.99777106478e-1f) * (z) - 3.33329491539e-1f)
+#endif
+
+static inline int32_t smfmasint(float x) {
+	int32_t i;
+	memcpy(&i, &x, sizeof(int32_t));
+	return i;
+}
+
+static inline float smfmasfloat(int32_t i) {
+	float x;
+	memcpy(&x, &i, sizeof(float));
+	return x;
+}
+
+static inline int32_t smfmround(float x) {
+	return (int32_t) (x + copysignf(0.5f, x));
+}
+
+/*
+ * Scalar approximations
+ */
+
+/**
+ * sin x if q is 0, cos x if q is 1.
+ */
+static inline float smfastsincosv(float x, int32_t q) {
+	int32_t k;
+	float y, r, z;
+	k = smfmround(x * (float) M_2_PI);
+	y = (float) k;
+	r = x - y * SMFM_PIO2_1;
+	SMFM_OPAQUE(r);
+	r -= y * SMFM_PIO2_2;
+	SMFM_OPAQUE(r);
+	r -= y * SMFM_PIO2_3;
+	z = r * r;
+	k += q;
+	if (k & 1) {
+		y = 1.0f - 0.5f * z + z * z * SMFM_COSP(z);
+	} else {
+		y = r + r * z * SMFM_SINP(z);
+	}
+	return k & 2 ? -y : y;
+}
+
+static inline float smfastsinv(float x) {
+	return smfastsincosv(x, 0);
+}
+
+static inline float smfastcosv(float x) {
+	return smfastsincosv(x, 1);
+}
+
+static inline float smfasttanv(float x) {
+	int32_t k;
+	float y, r, z;
+	k = smfmround(x * (float) M_2_PI);
+	y = (float) k;
+	r = x - y * SMFM_PIO2_1;
+	SMFM_OPAQUE(r);
+	r -= y * SMFM_PIO2_2;
+	SMFM_OPAQUE(r);
+	r -= y * SMFM_PIO2_3;
+	z = r * r;
+	y = r + r * z * SMFM_TANP(z);
+	return k & 1 ? -1.0f / y : y;
+}
+
+static inline float smfastexp2v(float x) {
+	int32_t k;
+	float r;
+	x = x < -126.0f ? -126.0f : x > 127.49f ? 127.49f : x;
+	k = smfmround(x);
+	r = x - (float) k;
+	return (1.0f + r * SMFM_EXP2P(r)) * smfmasfloat((k + 127) << 23);
+}
+
+/* log(m) and the binary exponent e, for x = 2^e m */
+static inline float smfastlogmv(float x, float *e) {
+	int32_t i, k;
+	float m, z;
+	i = smfmasint(x);
+	k = ((i >> 23) & 0xff) - 127;
+	m = smfmasfloat((i & 0x007fffff) | 0x3f800000);
+	if (m > SMFM_SQRT2) {
+		m *= 0.5f;
+		k++;
+	}
+	m -= 1.0f;
+	z = m * m;
+	*e = (float) k;
+	return m - 0.5f * z + m * z * SMFM_LOGP(m);
+}
+
+static inline float smfastlog2v(float x) {
+	float l, e;
+	l = smfastlogmv(x, &e);
+	return l * SMFM_LOG2E + e;
+}
+
+static inline float smfastlogv(float x) {
+	float l, e;
+	l = smfastlogmv(x, &e);
+	return l + e * SMFM_LN2;
+}
+
+static inline float smfastexpv(float x) {
+	return smfastexp2v(x * SMFM_LOG2E);
+}
+
+static inline float smfastpowv(float x, float y) {
+	return x > 0.0f ? smfastexp2v(y * smfastlog2v(x)) : 0.0f;
+}
+
+static inline float smfastatanv(float x) {
+	float a, y, z;
+	a = fabsf(x);
+	if (a > SMFM_TAN3PI_8) {
+		y = (float) M_PI_2;
+		a = -1.0f / a;
+	} else if (a > SMFM_TANPI_8) {
+		y = (float) M_PI_4;
+		a = (a - 1.0f) / (a + 1.0f);
+	} else {
+		y = 0.0f;
+	}
+	z = a * a;
+	y += a + a * z * SMFM_ATANP(z);
+	return copysignf(y, x);
+}
+
+/*
+ * Vector approximations
+ */
+
+static inline smvf smvfastsincos(smvf x, int32_t q) {
+	smvi k;
+	smvf y, r, z, s, c;
+	k = smvround(x * (float) M_2_PI);
+	y = __builtin_convertvector(k, smvf);
+	r = x - y * SMFM_PIO2_1;
+	SMFM_OPAQUE(r);
+	r -= y * SMFM_PIO2_2;
+	SMFM_OPAQUE(r);
+	r -= y * SMFM_PIO2_3;
+	z = r * r;
+	k += q;
+	c = 1.0f - 0.5f * z + z * z * SMFM_COSP(z);
+	s = r + r * z * SMFM_SINP(z);
+	y = smvselect((k & 1) != 0, c, s);
+	return (smvf) ((smvi) y ^ ((k & 2) << 30));
+}
+
+static inline smvf smvfastsin(smvf x) {
+	return smvfastsincos(x, 0);
+}
+
+static inline smvf smvfastcos(smvf x) {
+	return smvfastsincos(x, 1);
+}
+
+static inline smvf smvfasttan(smvf x) {
+	smvi k;
+	smvf y, r, z;
+	k = smvround(x * (float) M_2_PI);
+	y = __builtin_convertvector(k, smvf);
+	r = x - y * SMFM_PIO2_1;
+	SMFM_OPAQUE(r);
+	r -= y * SMFM_PIO2_2;
+	SMFM_OPAQUE(r);
+	r -= y * SMFM_PIO2_3;
+	z = r * r;
+	y = r + r * z * SMFM_TANP(z);
+	return smvselect((k & 1) != 0, -1.0f / y, y);
+}
+
+static inline smvf smvfastexp2(smvf x) {
+	smvi k;
+	smvf r;
+	x = smvselect(x < -126.0f, smvdup(-126.0f), x);
+	x = smvselect(x > 127.49f, smvdup(127.49f), x);
+	k = smvround(x);
+	r = x - __builtin_convertvector(k, smvf);
+	return (1.0f + r * SMFM_EXP2P(r)) * (smvf) ((k + 127) << 23);
+}
+
+static inline smvf smvfastlogm(smvf x, smvf *e) {
+	smvi i, k, big;
+	smvf m, z;
+	i = (smvi) x;
+	k = ((i >> 23) & 0xff) - 127;
+	m = (smvf) ((i & 0x007fffff) | 0x3f800000);
+	big = m > SMFM_SQRT2;
+	m = smvselect(big, m * 0.5f, m);
+	k -= big;
+	m -= 1.0f;
+	z = m * m;
+	*e = __builtin_convertvector(k, smvf);
+	return m - 0.5f * z + m * z * SMFM_LOGP(m);
+}
+
+static inline smvf smvfastlog2(smvf x) {
+	smvf l, e;
+	l = smvfastlogm(x, &e);
+	return l * SMFM_LOG2E + e;
+}
+
+static inline smvf smvfastlog(smvf x) {
+	smvf l, e;
+	l = smvfastlogm(x, &e);
+	return l + e * SMFM_LN2;
+}
+
+static inline smvf smvfastexp(smvf x) {
+	return smvfastexp2(x * SMFM_LOG2E);
+}
+
+static inline smvf smvfastpow(smvf x, smvf y) {
+	return (smvf) ((smvi) smvfastexp2(y * smvfastlog2(x)) & (x > 0.0f));
+}
+
+static inline smvf smvfastatan(smvf x) {
+	smvi big, mid;
+	smvf a, y, z;
+	a = smvabs(x);
+	big = a > SMFM_TAN3PI_8;
+	mid = a > SMFM_TANPI_8;
+	y = smvselect(big, smvdup((float) M_PI_2),
+		      (smvf) ((smvi) smvdup((float) M_PI_4) & mid));
+	a = smvselect(big, -1.0f / a,
+		      smvselect(mid, (a - 1.0f) / (a + 1.0f), a));
+	z = a * a;
+	y += a + a * z * SMFM_ATANP(z);
+	return smvcopysign(y, x);
+}
+
+/*
+ * The functions used by the library
+ */
+
+#if SMFASTMATH
+
+static inline float smsinv(float x) {
+	return smfastsinv(x);
+}
+static inline float smcosv(float x) {
+	return smfastcosv(x);
+}
+static inline float smtanv(float x) {
+	return smfasttanv(x);
+}
+static inline float smexp2v(float x) {
+	return smfastexp2v(x);
+}
+static inline float smlog2v(float x) {
+	return smfastlog2v(x);
+}
+static inline float smexpv(float x) {
+	return smfastexpv(x);
+}
+static inline float smlogv(float x) {
+	return smfastlogv(x);
+}
+static inline float smpowv(float x, float y) {
+	return smfastpowv(x, y);
+}
+static inline float smatanv(float x) {
+	return smfastatanv(x);
+}
+
+static inline smvf smvsin(smvf x) {
+	return smvfastsin(x);
+}
+static inline smvf smvcos(smvf x) {
+	return smvfastcos(x);
+}
+static inline smvf smvtan(smvf x) {
+	return smvfasttan(x);
+}
+static inline smvf smvexp2(smvf x) {
+	return smvfastexp2(x);
+}
+static inline smvf smvlog2(smvf x) {
+	return smvfastlog2(x);
+}
+static inline smvf smvexp(smvf x) {
+	return smvfastexp(x);
+}
+static inline smvf smvlog(smvf x) {
+	return smvfastlog(x);
+}
+static inline smvf smvpow(smvf x, smvf y) {
+	return smvfastpow(x, y);
+}
+static inline smvf smvatan(smvf x) {
+	return smvfastatan(x);
+}
+
+#else /* ! SMFASTMATH */
+
+static inline float smsinv(float x) {
+	return sinf(x);
+}
+static inline float smcosv(float x) {
+	return cosf(x);
+}
+static inline float smtanv(float x) {
+	return tanf(x);
+}
+static inline float smexp2v(float x) {
+	return exp2f(x);
+}
+static inline float smlog2v(float x) {
+	return log2f(x);
+}
+static inline float smexpv(float x) {
+	return expf(x);
+}
+static inline float smlogv(float x) {
+	return logf(x);
+}
+static inline float smpowv(float x, float y) {
+	return powf(x, y);
+}
+static inline float smatanv(float x) {
+	return atanf(x);
+}
+
+#define SMV_LIBM1(name, fn)					\
+	static inline smvf name(smvf x) {			\
+		int i;						\
+		for (i = 0; i < SMV_WIDTH; i++) {		\
+			x[i] = fn(x[i]);			\
+		}						\
+		return x;					\
+	}
+
+SMV_LIBM1(smvsin, sinf)
+SMV_LIBM1(smvcos, cosf)
+SMV_LIBM1(smvtan, tanf)
+SMV_LIBM1(smvexp2, exp2f)
+SMV_LIBM1(smvlog2, log2f)
+SMV_LIBM1(smvexp, expf)
+SMV_LIBM1(smvlog, logf)
+SMV_LIBM1(smvatan, atanf)
+
+#undef SMV_LIBM1
+
+static inline smvf smvpow(smvf x, smvf y) {
+	int i;
+	for (i = 0; i < SMV_WIDTH; i++) {
+		x[i] = powf(x[i], y[i]);
+	}
+	return x;
+}
+
+#endif /* ! SMFASTMATH */
+
+#endif /* ! SONICMATHS_FASTMATH_H */
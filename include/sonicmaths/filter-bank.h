@@ -0,0 +1,98 @@
+/** @file filter-bank.h
+ *
+ * Banks of filters, one per voice, processed several voices at a time.
+ *
+ * The filters are the same as those in filter.h, but the state of every
+ * voice is kept together so that the recursion can be advanced for
+ * SMV_WIDTH voices with each instruction. Each voice has its own input,
+ * output, frequency and resonance buffers.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_FILTER_BANK_H
+#define SONICMATHS_FILTER_BANK_H 1
+
+#include <sonicmaths/filter.h>
+
+/**
+ * The maximum number of state variables per voice.
+ */
+#define SMFBANK_NSTATES 8
+
+/**
+ * Filter bank
+ */
+struct smfbank {
+	int nvoices; /** The number of voices */
+	float *u; /** The state, grouped by SMV_WIDTH voices */
+};
+
+/**
+ * Initialize filter bank
+ */
+int smfbank_init(struct smfbank *bank, int nvoices);
+
+/**
+ * Destroy filter bank
+ */
+void smfbank_destroy(struct smfbank *bank);
+
+/**
+ * Clear the state of a single voice.
+ */
+void smfbank_reset(struct smfbank *bank, int voice);
+
+/**
+ * Prewarp n groups of SMV_WIDTH interleaved frequencies in place.
+ *
+ * cst[l] is set if lane l is constant over the block. This is what the
+ * filter bank uses internally, exported for other lane-parallel modules.
+ */
+void smfbank_prewarp(int n, float *w, int *cst);
+
+void smfbank1low(struct smfbank *bank, int n, float **y, float **x,
+		 float **f);
+void smfbank1high(struct smfbank *bank, int n, float **y, float **x,
+		  float **f);
+void smfbank2low(struct smfbank *bank, int n, float **y, float **x,
+		 float **f, float **r);
+void smfbank2high(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r);
+void smfbank2band(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r);
+void smfbank3low(struct smfbank *bank, int n, float **y, float **x,
+		 float **f, float **r);
+void smfbank3high(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r);
+void smfbank4low(struct smfbank *bank, int n, float **y, float **x,
+		 float **f, float **r);
+void smfbank4high(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r);
+void smfbank4band(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r);
+void smfbank6band(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r);
+void smfbank8band(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r);
+void smfbank3lowres(struct smfbank *bank, int n, float **y, float **x,
+		    float **f, float **r);
+void smfbank4lowres(struct smfbank *bank, int n, float **y, float **x,
+		    float **f, float **r);
+
+#endif /* ! SONICMATHS_FILTER_BANK_H */
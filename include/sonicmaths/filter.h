@@ -24,19 +24,73 @@
 #define SONICMATHS_FILTER_H 1
 
 #include <sonicmaths/math.h>
+#include <sonicmaths/fastmath.h>
 #include <math.h>
 
 #define SMF_BWP21	 1.414213562373095f
 #define SMF_BWP31	1.0f
 #define SMF_BWP41	0.7653668647301796f
 #define SMF_BWP42	 1.847759065022574f
+#define SMF_BWP51	0.6180339887498948f
+#define SMF_BWP52	 1.618033988749895f
 #define SMF_BWP61	0.5176380902050414f
 #define SMF_BWP62	 1.414213562373095f
 #define SMF_BWP63	 1.931851652578136f
+#define SMF_BWP71	0.4450418679126288f
+#define SMF_BWP72	 1.246979603717467f
+#define SMF_BWP73	 1.801937735804838f
 #define SMF_BWP81	0.3901806440322565f
 #define SMF_BWP82	 1.111140466039204f
 #define SMF_BWP83	 1.662939224605090f
 #define SMF_BWP84	 1.961570560806461f
+#define SMF_BWP91	0.3472963553338607f
+#define SMF_BWP92	1.0f
+#define SMF_BWP93	 1.532088886237956f
+#define SMF_BWP94	 1.879385241571817f
+#define SMF_BWP10_1	0.3128689300804617f
+#define SMF_BWP10_2	0.9079809994790935f
+#define SMF_BWP10_3	 1.414213562373095f
+#define SMF_BWP10_4	 1.782013048376736f
+#define SMF_BWP10_5	 1.975376681190276f
+#define SMF_BWP11_1	0.2846296765465703f
+#define SMF_BWP11_2	0.8308300260037728f
+#define SMF_BWP11_3	 1.309721467890570f
+#define SMF_BWP11_4	 1.682507065662362f
+#define SMF_BWP11_5	 1.918985947228995f
+#define SMF_BWP12_1	0.2610523844401031f
+#define SMF_BWP12_2	0.7653668647301796f
+#define SMF_BWP12_3	 1.217522858017441f
+#define SMF_BWP12_4	 1.586706680582470f
+#define SMF_BWP12_5	 1.847759065022573f
+#define SMF_BWP12_6	 1.982889722747621f
+#define SMF_BWP13_1	0.2410733605106461f
+#define SMF_BWP13_2	0.7092097740850712f
+#define SMF_BWP13_3	 1.136129493462312f
+#define SMF_BWP13_4	 1.497021496342202f
+#define SMF_BWP13_5	 1.770912051306420f
+#define SMF_BWP13_6	 1.941883634852104f
+#define SMF_BWP14_1	0.2239289522066157f
+#define SMF_BWP14_2	0.6605581239103342f
+#define SMF_BWP14_3	 1.064064153030673f
+#define SMF_BWP14_4	 1.414213562373095f
+#define SMF_BWP14_5	 1.693448398456568f
+#define SMF_BWP14_6	 1.887766660616735f
+#define SMF_BWP14_7	 1.987424419786485f
+#define SMF_BWP15_1	0.2090569265353069f
+#define SMF_BWP15_2	0.6180339887498948f
+#define SMF_BWP15_3	1.0f
+#define SMF_BWP15_4	 1.338261212717716f
+#define SMF_BWP15_5	 1.618033988749895f
+#define SMF_BWP15_6	 1.827090915285202f
+#define SMF_BWP15_7	 1.956295201467611f
+#define SMF_BWP16_1	0.1960342806591212f
+#define SMF_BWP16_2	0.5805693545089247f
+#define SMF_BWP16_3	0.9427934736519953f
+#define SMF_BWP16_4	 1.268786568327291f
+#define SMF_BWP16_5	 1.546020906725474f
+#define SMF_BWP16_6	 1.763842528696710f
+#define SMF_BWP16_7	 1.913880671464418f
+#define SMF_BWP16_8	 1.990369453344394f
 
 #define SMF_BWQ		0.7071067811865475f
 
@@ -44,35 +98,64 @@
 #define SMF_FMIN	0.0001f
 
 static inline float smff2w_2(float f) {
-	return tanf((f > SMF_FMAX ? SMF_FMAX : f < SMF_FMIN ? SMF_FMIN : f)
-		    * (float) M_PI);
+	return smtanv((f > SMF_FMAX ? SMF_FMAX : f < SMF_FMIN ? SMF_FMIN : f)
+		      * (float) M_PI);
 }
 
-static inline float smf1lowv(float *u, float x, float w_2) {
+/**
+ * Reciprocal of the denominator of a first order stage.
+ */
+static inline float smf1g(float w_2) {
+	return 1.0f / (1.0f + w_2);
+}
+
+/**
+ * Reciprocal of the denominator of a second order stage.
+ */
+static inline float smf2g(float w_2, float a) {
+	return 1.0f / (1.0f + a * w_2 + w_2 * w_2);
+}
+
+/*
+ * The *gv variants take the reciprocal denominator g precomputed by smf1g()
+ * or smf2g(), so that it may be hoisted out of a loop when the coefficients
+ * are constant. The plain *v variants compute g themselves and give
+ * identical results.
+ */
+
+static inline float smf1lowgv(float *u, float x, float w_2, float g) {
 	float t1, t2, u1;
 	u1 = u[0];
-	t1 = (x - u1) / (1.0f + w_2);
+	t1 = (x - u1) * g;
 	t2 = u1 + w_2 * t1;
 	u1 = w_2 * t1 + t2;
 	u[0] = SMFPNORM(u1);
 	return t2;
 }
 
-static inline float smf1highv(float *u, float x, float w_2) {
+static inline float smf1lowv(float *u, float x, float w_2) {
+	return smf1lowgv(u, x, w_2, smf1g(w_2));
+}
+
+static inline float smf1highgv(float *u, float x, float w_2, float g) {
 	float t1, t2, u1;
 	u1 = u[0];
-	t1 = (x - u1) / (1.0f + w_2);
+	t1 = (x - u1) * g;
 	t2 = u1 + w_2 * t1;
 	u1 = w_2 * t1 + t2;
 	u[0] = SMFPNORM(u1);
 	return t1;
 }
 
-static inline void smf1splitv(float *u, float *low, float *high, float x,
-			      float w_2) {
+static inline float smf1highv(float *u, float x, float w_2) {
+	return smf1highgv(u, x, w_2, smf1g(w_2));
+}
+
+static inline void smf1splitgv(float *u, float *low, float *high, float x,
+			       float w_2, float g) {
 	float t1, t2, u1;
 	u1 = u[0];
-	t1 = (x - u1) / (1.0f + w_2);
+	t1 = (x - u1) * g;
 	t2 = u1 + w_2 * t1;
 	u1 = w_2 * t1 + t2;
 	u[0] = SMFPNORM(u1);
@@ -80,11 +163,17 @@ static inline void smf1splitv(float *u, float *low, float *high, float x,
 	*high = t1;
 }
 
-static inline float smf2lowv(float *u, float x, float w_2, float a) {
+static inline void smf1splitv(float *u, float *low, float *high, float x,
+			      float w_2) {
+	smf1splitgv(u, low, high, x, w_2, smf1g(w_2));
+}
+
+static inline float smf2lowgv(float *u, float x, float w_2, float a,
+			      float g) {
 	float t1, t2, t3, u1, u2;
 	u1 = u[0];
 	u2 = u[1];
-	t1 = (x - (w_2 + a) * u1 - u2) / (1.0f + a * w_2 + w_2 * w_2);
+	t1 = (x - (w_2 + a) * u1 - u2) * g;
 	t2 = u1 + w_2 * t1;
 	t3 = u2 + w_2 * t2;
 	u1 = w_2 * t1 + t2;
@@ -94,11 +183,16 @@ static inline float smf2lowv(float *u, float x, float w_2, float a) {
 	return t3;
 }
 
-static inline float smf2highv(float *u, float x, float w_2, float a) {
+static inline float smf2lowv(float *u, float x, float w_2, float a) {
+	return smf2lowgv(u, x, w_2, a, smf2g(w_2, a));
+}
+
+static inline float smf2highgv(float *u, float x, float w_2, float a,
+			       float g) {
 	float t1, t2, t3, u1, u2;
 	u1 = u[0];
 	u2 = u[1];
-	t1 = (x - (w_2 + a) * u1 - u2) / (1.0f + a * w_2 + w_2 * w_2);
+	t1 = (x - (w_2 + a) * u1 - u2) * g;
 	t2 = u1 + w_2 * t1;
 	t3 = u2 + w_2 * t2;
 	u1 = w_2 * t1 + t2;
@@ -108,11 +202,16 @@ static inline float smf2highv(float *u, float x, float w_2, float a) {
 	return t1;
 }
 
-static inline float smf2bandv(float *u, float x, float w_2, float a) {
+static inline float smf2highv(float *u, float x, float w_2, float a) {
+	return smf2highgv(u, x, w_2, a, smf2g(w_2, a));
+}
+
+static inline float smf2bandgv(float *u, float x, float w_2, float a,
+			       float g) {
 	float t1, t2, t3, u1, u2;
 	u1 = u[0];
 	u2 = u[1];
-	t1 = (x - (w_2 + a) * u1 - u2) / (1.0f + a * w_2 + w_2 * w_2);
+	t1 = (x - (w_2 + a) * u1 - u2) * g;
 	t2 = u1 + w_2 * t1;
 	t3 = u2 + w_2 * t2;
 	u1 = w_2 * t1 + t2;
@@ -122,12 +221,16 @@ static inline float smf2bandv(float *u, float x, float w_2, float a) {
 	return t2;
 }
 
-static inline void smf2splitv(float *u, float *low, float *high, float x,
-			      float w_2, float a) {
+static inline float smf2bandv(float *u, float x, float w_2, float a) {
+	return smf2bandgv(u, x, w_2, a, smf2g(w_2, a));
+}
+
+static inline void smf2splitgv(float *u, float *low, float *high, float x,
+			       float w_2, float a, float g) {
 	float t1, t2, t3, u1, u2;
 	u1 = u[0];
 	u2 = u[1];
-	t1 = (x - (w_2 + a) * u1 - u2) / (1.0f + a * w_2 + w_2 * w_2);
+	t1 = (x - (w_2 + a) * u1 - u2) * g;
 	t2 = u1 + w_2 * t1;
 	t3 = u2 + w_2 * t2;
 	u1 = w_2 * t1 + t2;
@@ -138,18 +241,138 @@ static inline void smf2splitv(float *u, float *low, float *high, float x,
 	*high = t1;
 }
 
+static inline void smf2splitv(float *u, float *low, float *high, float x,
+			      float w_2, float a) {
+	smf2splitgv(u, low, high, x, w_2, a, smf2g(w_2, a));
+}
+
+/*
+ * Second order allpass: low + high - a band. With a = SMF_BWP21 this has
+ * the same phase as the sum of the two outputs of a Linkwitz-Riley split.
+ */
+static inline float smf2allpassgv(float *u, float x, float w_2, float a,
+				  float g) {
+	return x - 2.0f * a * smf2bandgv(u, x, w_2, a, g);
+}
+
+static inline float smf2allpassv(float *u, float x, float w_2, float a) {
+	return smf2allpassgv(u, x, w_2, a, smf2g(w_2, a));
+}
+
+/*
+ * The block filters below check whether f and r are constant over the block
+ * (see smisconst()) and, if so, compute their coefficients once for the
+ * whole block. Both paths evaluate the same expressions, so the output is
+ * the same either way (bit for bit, as long as the compiler is not allowed to
+ * reassociate them differently, as it is with -ffast-math).
+ *
+ * When f varies, building with -DSMFINTERP=K computes the prewarped
+ * frequency exactly only every K samples and ramps it linearly in between;
+ * the damping term is still exact at every sample, since it costs no more
+ * to compute than to ramp. Measured on smf4low at 44.1kHz, r = 0.5, with f
+ * swept +/-2.5 octaves around 1kHz, the maximum error relative to the peak
+ * output is:
+ *
+ *	K	2Hz sweep	440Hz sweep
+ *	4	-113dB		-33dB
+ *	8	-104dB		-20dB
+ *	16	-92dB		-8dB
+ *	32	-80dB		-1dB
+ *
+ * So it is meant for LFO and envelope modulation, not for FM of the cutoff.
+ */
+
 void smf1low(float *u, int n, float *y, float *x, float *f);
 void smf1high(float *u, int n, float *y, float *x, float *f);
 void smf2low(float *u, int n, float *y, float *x, float *f, float *r);
 void smf2high(float *u, int n, float *y, float *x, float *f, float *r);
 void smf2band(float *u, int n, float *y, float *x, float *f, float *r);
+/*
+ * Butterworth cascades of order 3 to 16, bandpass for even orders only.
+ * smf<N>* requires u[N].
+ */
 void smf3low(float *u, int n, float *y, float *x, float *f, float *r);
 void smf3high(float *u, int n, float *y, float *x, float *f, float *r);
 void smf4low(float *u, int n, float *y, float *x, float *f, float *r);
 void smf4high(float *u, int n, float *y, float *x, float *f, float *r);
 void smf4band(float *u, int n, float *y, float *x, float *f, float *r);
+void smf5low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf5high(float *u, int n, float *y, float *x, float *f, float *r);
+void smf6low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf6high(float *u, int n, float *y, float *x, float *f, float *r);
 void smf6band(float *u, int n, float *y, float *x, float *f, float *r);
+void smf7low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf7high(float *u, int n, float *y, float *x, float *f, float *r);
+void smf8low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf8high(float *u, int n, float *y, float *x, float *f, float *r);
 void smf8band(float *u, int n, float *y, float *x, float *f, float *r);
+void smf9low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf9high(float *u, int n, float *y, float *x, float *f, float *r);
+void smf10low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf10high(float *u, int n, float *y, float *x, float *f, float *r);
+void smf10band(float *u, int n, float *y, float *x, float *f, float *r);
+void smf11low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf11high(float *u, int n, float *y, float *x, float *f, float *r);
+void smf12low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf12high(float *u, int n, float *y, float *x, float *f, float *r);
+void smf12band(float *u, int n, float *y, float *x, float *f, float *r);
+void smf13low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf13high(float *u, int n, float *y, float *x, float *f, float *r);
+void smf14low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf14high(float *u, int n, float *y, float *x, float *f, float *r);
+void smf14band(float *u, int n, float *y, float *x, float *f, float *r);
+void smf15low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf15high(float *u, int n, float *y, float *x, float *f, float *r);
+void smf16low(float *u, int n, float *y, float *x, float *f, float *r);
+void smf16high(float *u, int n, float *y, float *x, float *f, float *r);
+void smf16band(float *u, int n, float *y, float *x, float *f, float *r);
+
+/*
+ * Fixed-coefficient versions of the above for long blocks where f and r do
+ * not change, such as offline renders. Each stage produces SMV_WIDTH outputs
+ * at a time from its state and the next SMV_WIDTH inputs (a look-ahead
+ * state space evaluation) rather than one sample at a time, and the stages
+ * of a cascade run one after another over the whole block. The output
+ * agrees with the per-sample filters to within float rounding.
+ */
+void smf2lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf2highla(float *u, int n, float *y, float *x, float f, float r);
+void smf2bandla(float *u, int n, float *y, float *x, float f, float r);
+void smf3lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf3highla(float *u, int n, float *y, float *x, float f, float r);
+void smf4lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf4highla(float *u, int n, float *y, float *x, float f, float r);
+void smf4bandla(float *u, int n, float *y, float *x, float f, float r);
+void smf5lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf5highla(float *u, int n, float *y, float *x, float f, float r);
+void smf6lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf6highla(float *u, int n, float *y, float *x, float f, float r);
+void smf6bandla(float *u, int n, float *y, float *x, float f, float r);
+void smf7lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf7highla(float *u, int n, float *y, float *x, float f, float r);
+void smf8lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf8highla(float *u, int n, float *y, float *x, float f, float r);
+void smf8bandla(float *u, int n, float *y, float *x, float f, float r);
+void smf9lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf9highla(float *u, int n, float *y, float *x, float f, float r);
+void smf10lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf10highla(float *u, int n, float *y, float *x, float f, float r);
+void smf10bandla(float *u, int n, float *y, float *x, float f, float r);
+void smf11lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf11highla(float *u, int n, float *y, float *x, float f, float r);
+void smf12lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf12highla(float *u, int n, float *y, float *x, float f, float r);
+void smf12bandla(float *u, int n, float *y, float *x, float f, float r);
+void smf13lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf13highla(float *u, int n, float *y, float *x, float f, float r);
+void smf14lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf14highla(float *u, int n, float *y, float *x, float f, float r);
+void smf14bandla(float *u, int n, float *y, float *x, float f, float r);
+void smf15lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf15highla(float *u, int n, float *y, float *x, float f, float r);
+void smf16lowla(float *u, int n, float *y, float *x, float f, float r);
+void smf16highla(float *u, int n, float *y, float *x, float f, float r);
+void smf16bandla(float *u, int n, float *y, float *x, float f, float r);
 
 /* requires u[6] */
 static inline void smf4linkwitz_rileyv(float *u, float *low, float *high, float x, float w_2) {
@@ -159,6 +382,13 @@ static inline void smf4linkwitz_rileyv(float *u, float *low, float *high, float
 	*high = smf2highv(u+4, t2, w_2, SMF_BWP21);
 }
 
+/**
+ * Linkwitz-Riley split of a block at a fixed w_2. Requires u[6]. low may be
+ * the same buffer as x.
+ */
+void smf4linkwitz_riley(float *u, int n, float *low, float *high, float *x,
+			float w_2);
+
 /* requires u[6] multiplied by 1/(2 bw) */
 void smf4split(float *u, int n, float **y, float *x, float *bw);
 
@@ -0,0 +1,107 @@
+/** @file fm.h
+ *
+ * Phase modulation synthesis: operators of many voices, as in FM synths.
+ *
+ * Each operator is a cosine with a fixed-point phase, as in smcosq(), whose
+ * phase is modulated by the other operators. The routing is one matrix for
+ * the whole engine: mod[k][j] is the amount, in cycles, by which operator j
+ * modulates operator k. The operators are evaluated from the last to the
+ * first, so entries with j > k use operator j's output for the same
+ * sample, and entries with j <= k, including the diagonal, feed back the
+ * output of the sample before. The output of the voice is the sum of the
+ * operators weighted by out[].
+ *
+ * The frequency ratio and level of each operator can be set per voice. The
+ * phases and the other per-voice data are kept in groups of SMV_WIDTH
+ * voices, one per lane, and every operator of every voice in a group is
+ * worked out per sample in one loop, without intermediate buffers.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_FM_H
+#define SONICMATHS_FM_H 1
+
+#include <stdint.h>
+#include <sonicmaths/vector.h>
+
+/**
+ * The maximum number of operators.
+ */
+#define SMFM_MAXOPS 8
+
+/**
+ * FM engine
+ */
+struct smfm {
+	int nvoices; /** The number of voices */
+	int nops; /** The number of operators in each voice */
+	float mod[SMFM_MAXOPS][SMFM_MAXOPS]; /** The routing */
+	float out[SMFM_MAXOPS]; /** The output level of each operator */
+	uint32_t *t; /** The phases */
+	float *ratio; /** The frequency ratios */
+	float *level; /** The operator levels */
+	float *y1; /** The last outputs, for feedback */
+};
+
+/**
+ * Initialize FM engine
+ *
+ * nops must be between 1 and SMFM_MAXOPS. The operators start with ratio
+ * and level 1, no routing, and only the first in the output.
+ */
+int smfm_init(struct smfm *fm, int nvoices, int nops);
+
+/**
+ * Destroy FM engine
+ */
+void smfm_destroy(struct smfm *fm);
+
+/* the index of an operator of a voice in t, ratio, level and y1 */
+static inline int smfm_index(struct smfm *fm, int voice, int op) {
+	return ((voice / SMV_WIDTH) * fm->nops + op) * SMV_WIDTH
+		+ voice % SMV_WIDTH;
+}
+
+/**
+ * Set the frequency of an operator of a voice, as a multiple of f.
+ */
+static inline void smfm_set_ratio(struct smfm *fm, int voice, int op,
+				  float ratio) {
+	fm->ratio[smfm_index(fm, voice, op)] = ratio;
+}
+
+/**
+ * Set the level of an operator of a voice.
+ */
+static inline void smfm_set_level(struct smfm *fm, int voice, int op,
+				  float level) {
+	fm->level[smfm_index(fm, voice, op)] = level;
+}
+
+/**
+ * Restart the operators of a voice at phase 0, without feedback.
+ */
+void smfm_reset(struct smfm *fm, int voice);
+
+/**
+ * Run the voices, with voice v at frequency f[v] into y[v].
+ */
+void smfm(struct smfm *fm, int n, float **y, float **f);
+
+#endif /* ! SONICMATHS_FM_H */
@@ -0,0 +1,93 @@
+/** @file granular.h
+ *
+ * Granular synthesis
+ *
+ * Each grain reads from a source buffer, starting at its own position and
+ * moving through it at its own rate, under a window, and is panned into a
+ * stereo pair. Grains are kept together, field by field, and are worked on
+ * SMV_WIDTH at a time, so that many thousands of them may sound at once.
+ *
+ * The windows are tabulated the first time a granulator is initialized.
+ * SMGRAIN_LINEAR and SMGRAIN_EXPONENTIAL are the attack and release of
+ * smenvgl() and smenvg(), each over half the grain, scaled to begin and end
+ * at zero.
+ *
+ * The source is read with cubic interpolation. Grains are silent where they
+ * would read outside it.
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_GRANULAR_H
+#define SONICMATHS_GRANULAR_H 1
+
+/**
+ * Grain window
+ */
+enum smgrain_window {
+	SMGRAIN_HANN = 0,
+	SMGRAIN_LINEAR,
+	SMGRAIN_EXPONENTIAL
+};
+
+/**
+ * Granulator
+ */
+struct smgranular {
+	int maxgrains; /** The number of grains there is room for */
+	int ngrains; /** The number of grains sounding or waiting */
+	int *wait; /** The samples before each grain starts */
+	int *j; /** The whole part of each read position */
+	float *u; /** The fractional part of each read position */
+	float *rate; /** The read rates */
+	float *w; /** The window phases, from 0 to 1 */
+	float *dw; /** The window rates */
+	int *win; /** The offsets of the windows in their table */
+	float *gl; /** The gains into the left channel */
+	float *gr; /** The gains into the right channel */
+};
+
+/**
+ * Initialize granulator, with room for maxgrains grains at once.
+ */
+int smgranular_init(struct smgranular *gran, int maxgrains);
+
+/**
+ * Destroy granulator
+ */
+void smgranular_destroy(struct smgranular *gran);
+
+/**
+ * Start a grain delay samples into the next call to smgranular(), reading
+ * from pos at rate samples per sample for dur samples. pan runs from -1, left,
+ * to 1, right, at equal power. Returns -1 if there is no room for the grain.
+ */
+int smgranular_add(struct smgranular *gran, int delay, double pos, float rate,
+		   float dur, float pan, float amp, enum smgrain_window win);
+
+/**
+ * Silence every grain.
+ */
+void smgranular_reset(struct smgranular *gran);
+
+/**
+ * Play the grains from the len samples of src into yl and yr.
+ */
+void smgranular(struct smgranular *gran, int n, float *yl, float *yr,
+		const float *src, int len);
+
+#endif /* ! SONICMATHS_GRANULAR_H */
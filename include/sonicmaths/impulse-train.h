@@ -31,8 +31,42 @@ n=1
 #ifndef SONICMATHS_IMPULSE_TRAIN_H
 #define SONICMATHS_IMPULSE_TRAIN_H 1
 
+#include <math.h>
+#include <sonicmaths/fastmath.h>
 #include <sonicmaths/oscillator.h>
 
+/**
+ * One sample of the impulse train, at phase t (in cycles) and frequency f.
+ */
+static inline float smitrainv(double t, float f) {
+	float wt_2, nh, ha, sinw_2, cosn1w_2;
+	ha = 1.0f / (2.0f * f);
+	nh = floorf(ha); /* the number of harmonics */
+	ha -= nh; /* the strength of the top harmonic */
+	nh -= 1.0f;
+	/* the train repeats every cycle; measuring t from the nearest
+	 * impulse keeps sin(wt_2) accurate where it goes to zero */
+	wt_2 = ((float) M_PI) * (float) (t - rint(t));
+	sinw_2 = smsinv(wt_2);
+	cosn1w_2 = smcosv((nh + 1.0f) * wt_2);
+	return cosn1w_2 * (sinw_2 != 0.0f ? smsinv(nh * wt_2) / sinw_2 : nh)
+		+ ha * (2.0f * cosn1w_2 * cosn1w_2 - 1.0f);
+}
+
+/*
+ * While f and phi are constant over a block, the trigonometric terms are
+ * advanced by complex rotation instead of being evaluated every sample,
+ * except close to the impulses, where they are evaluated directly.
+ */
 void smitrain(struct smosc *osc, int n, float *y, float *f, float *phi);
 
+/**
+ * smitrain() for nosc oscillators, osc[0..nosc-1], SMV_WIDTH at a time.
+ *
+ * A group of oscillators whose f and phi are all constant over the block
+ * runs in the SIMD lanes; any other group runs one oscillator at a time.
+ */
+void smitrainbank(struct smosc *osc, int nosc, int n, float **y, float **f,
+		  float **phi);
+
 #endif /* ! SONICMATHS_IMPULSE_TRAIN */
@@ -50,6 +50,34 @@ struct smintg {
 	float x6;
 };
 
+#define SMINTG_WSINC_0 0.851781806f
+#define SMINTG_WSINC_1 0.0887156468f
+#define SMINTG_WSINC_2 -0.0167572966f
+#define SMINTG_WSINC_3 0.00215077831f
+
+#define SMINTG_LEAKINESS 0.999f
+
+/**
+ * Integrate one sample. Work on a local copy of the state in loops, so that
+ * it can be kept in registers.
+ */
+static inline float smintgv(struct smintg *intg, float x) {
+	float y;
+	y =   (x + intg->x6) * SMINTG_WSINC_3
+	    + (intg->x1 + intg->x5) * SMINTG_WSINC_2
+	    + (intg->x2 + intg->x4) * SMINTG_WSINC_1
+	    + intg->x3 * SMINTG_WSINC_0
+	    + intg->y1 * SMINTG_LEAKINESS;
+	intg->y1 = y;
+	intg->x6 = intg->x5;
+	intg->x5 = intg->x4;
+	intg->x4 = intg->x3;
+	intg->x3 = intg->x2;
+	intg->x2 = intg->x1;
+	intg->x1 = x;
+	return y;
+}
+
 /**
  * Initialize integration filter
  */
@@ -61,13 +61,14 @@ r * 2
 #define SONICMATHS_KEY_H 1
 
 #include <math.h>
+#include <sonicmaths/fastmath.h>
 
 static inline float smn2fv(float note, float root) {
-	return root * powf(2.0f, note);
+	return root * smexp2v(note);
 }
 
 static inline float smf2nv(float freq, float root) {
-	return log2f(freq / root);
+	return smlog2v(freq / root);
 }
 
 void smn2f(int n, float *freq, float *note, float *root);
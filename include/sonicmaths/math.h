@@ -24,8 +24,13 @@
 #define SONICMATHS_MATH_H 1
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <math.h>
 #include <float.h>
+#if defined(__SSE__)
+# include <xmmintrin.h>
+#endif
 
 static inline float smnormtv(float sample_rate, float t) {
 	return t * sample_rate;
@@ -35,11 +40,110 @@ static inline float smnormfv(float sample_rate, float f) {
 	return f / sample_rate;
 }
 
-#define SMFPNORM(x)		\
+/**
+ * Test whether a block of values is constant.
+ *
+ * Returns nonzero if n > 0 and every x[i] equals x[0].
+ */
+static inline int smisconst(int n, float *x) {
+	int i, c;
+	float x0;
+	if (n <= 0) {
+		return 0;
+	}
+	x0 = x[0];
+	c = 0;
+	for (i = 1; i < n; i++) {
+		c |= x[i] != x0;
+	}
+	return !c;
+}
+
+/*
+ * Denormals and non-finite values.
+ *
+ * The recursive kernels (filters, integrator, lag, envelope generator,
+ * reverb) no longer check their state every sample. Instead, the processing
+ * thread should call smfpflush() once, so that denormals are flushed to zero
+ * in hardware, and each block function repairs its stored state with
+ * smfprepair() once per block. Define SMFPSANITIZE to get the old
+ * per-sample checks back through SMFPNORM.
+ */
+
+#ifdef SMFPSANITIZE
+# define SMFPNORM(x)		\
 	(isfinite(x) ? (x)	\
 	 : isnan(x) ? 0.0f	\
 	 : x > 0.0f ? HUGE_VALF	\
 	 : -HUGE_VALF)
+#else
+# define SMFPNORM(x) (x)
+#endif
+
+/**
+ * Replace NaN or infinity by 0.
+ *
+ * This tests the bit pattern, so unlike isfinite() it is not compiled away
+ * under -ffast-math.
+ */
+static inline float smfprepairv(float x) {
+	uint32_t b;
+	memcpy(&b, &x, sizeof(b));
+	return (b & 0x7f800000u) == 0x7f800000u ? 0.0f : x;
+}
+
+/**
+ * Replace every NaN or infinity in u[0..n-1] by 0.
+ */
+static inline void smfprepair(float *u, int n) {
+	int i;
+	for (i = 0; i < n; i++) {
+		u[i] = smfprepairv(u[i]);
+	}
+}
+
+/**
+ * Flush denormals to zero on the calling thread.
+ *
+ * Sets flush-to-zero and denormals-are-zero on x86 (SSE only; x87 code is
+ * unaffected) and flush-to-zero on ARM. Returns the previous mode, to be
+ * passed to smfprestore(). Does nothing on other architectures.
+ */
+static inline unsigned long smfpflush(void) {
+#if defined(__SSE__)
+	unsigned int csr;
+	csr = _mm_getcsr();
+	_mm_setcsr(csr | 0x8040); /* FTZ | DAZ */
+	return csr;
+#elif defined(__aarch64__)
+	unsigned long fpcr;
+	__asm__ __volatile__("mrs %0, fpcr" : "=r" (fpcr));
+	__asm__ __volatile__("msr fpcr, %0" : : "r" (fpcr | (1ul << 24)));
+	return fpcr;
+#elif defined(__arm__) && defined(__ARM_FP)
+	unsigned int fpscr;
+	__asm__ __volatile__("vmrs %0, fpscr" : "=r" (fpscr));
+	__asm__ __volatile__("vmsr fpscr, %0" : : "r" (fpscr | (1u << 24)));
+	return fpscr;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Restore the mode returned by smfpflush().
+ */
+static inline void smfprestore(unsigned long mode) {
+#if defined(__SSE__)
+	_mm_setcsr((unsigned int) mode);
+#elif defined(__aarch64__)
+	__asm__ __volatile__("msr fpcr, %0" : : "r" (mode));
+#elif defined(__arm__) && defined(__ARM_FP)
+	__asm__ __volatile__("vmsr fpscr, %0" : : "r" ((unsigned int) mode));
+#else
+	(void) mode;
+#endif
+}
 
 static inline float smblprewarp(float w) {
 	return 2.0f * atan(w / 2.0f);
@@ -0,0 +1,88 @@
+/** @file minblep.h
+ *
+ * Sawtooth and pulse oscillators with hard sync, band-limited by minBLEP.
+ *
+ * The waveforms are computed naively, and each jump in them is corrected by
+ * adding the difference between a band-limited step and a hard one over
+ * the following SMBLEP_LEN samples. The band-limited step is the integral of
+ * a minimum phase windowed sinc, tabulated at SMBLEP_OVERSAMPLE points per
+ * sample the first time an oscillator is initialized, so that the
+ * correction falls almost entirely after the jump. Jumps are placed to a
+ * fraction of a sample, which keeps the result free of aliasing without
+ * oversampling.
+ *
+ * Each jump is spread over the samples after it, and so lands on average
+ * about 2.5 samples late. The sawtooth's ramp is raised by 2f times that lag,
+ * measured once from the table, which leaves it without DC.
+ *
+ * The oscillator is reset to the start of its cycle wherever the sync input
+ * crosses zero going up, at the point found by linear interpolation.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_MINBLEP_H
+#define SONICMATHS_MINBLEP_H 1
+
+#include <sonicmaths/oscillator.h>
+
+/**
+ * The length of the correction for each jump, in samples.
+ */
+#define SMBLEP_LEN 32
+
+/**
+ * Points per sample in the table of the step.
+ */
+#define SMBLEP_OVERSAMPLE 64
+
+/**
+ * minBLEP oscillator
+ */
+struct smblep {
+	struct smosc osc; /** The phase */
+	float sync1; /** The last sample of the sync input */
+	int i; /** The position of the current sample in r */
+	float r[SMBLEP_LEN]; /** The corrections still to be added */
+};
+
+/**
+ * Initialize minBLEP oscillator
+ */
+int smblep_init(struct smblep *blep);
+
+/**
+ * Destroy minBLEP oscillator
+ */
+void smblep_destroy(struct smblep *blep);
+
+/**
+ * Sawtooth, falling from 1 to -1 over each cycle, synced to sync if it is
+ * not NULL. f must be between 0 and 0.5.
+ */
+void smblepsaw(struct smblep *blep, int n, float *y, float *f, float *sync);
+
+/**
+ * Pulse, high for the fraction w of each cycle, synced to sync if it is not
+ * NULL. The jump is 2, and the wave has no DC. f must be between 0 and 0.5,
+ * and w between 0 and 1.
+ */
+void smbleppulse(struct smblep *blep, int n, float *y, float *f, float *w,
+		 float *sync);
+
+#endif /* ! SONICMATHS_MINBLEP_H */
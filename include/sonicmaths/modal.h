@@ -0,0 +1,77 @@
+/** @file modal.h
+ *
+ * Modal synthesis: a bank of damped resonators sharing one excitation.
+ *
+ * Each mode is the bandpass of smf2bandgv(), with its coefficients chosen
+ * so that its poles fall exactly at the frequency and decay asked for, and
+ * its input scaled so that a unit impulse sets it ringing at the given
+ * gain. The coefficients and the state are kept one array per quantity, and
+ * the modes are run SMV_WIDTH at a time, several vectors together, over
+ * blocks of the excitation. A mode may be changed at any time; this costs
+ * an exp, a sin and a cos, two square roots, a few divisions and three
+ * steps of the filter to measure the gain of its impulse response. The
+ * filter keeps its state through the change without clicks.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_MODAL_H
+#define SONICMATHS_MODAL_H 1
+
+/**
+ * Modal resonator bank
+ */
+struct smmodal {
+	int nmodes; /** The number of modes */
+	float *w_2; /** The prewarped frequency of each mode */
+	float *aw; /** The damping plus w_2 */
+	float *g; /** The reciprocal denominator, as from smf2g() */
+	float *s; /** The input scale */
+	float *u1; /** The first state variable of each mode */
+	float *u2; /** The second state variable of each mode */
+};
+
+/**
+ * Initialize modal resonator bank. The modes start out silent.
+ */
+int smmodal_init(struct smmodal *mb, int nmodes);
+
+/**
+ * Destroy modal resonator bank
+ */
+void smmodal_destroy(struct smmodal *mb);
+
+/**
+ * Set mode k to ring at frequency f, with its amplitude falling by a factor
+ * of e every decay samples and starting at gain for a unit impulse. A mode
+ * not below Nyquist is silent.
+ */
+void smmodal_set(struct smmodal *mb, int k, float f, float decay,
+		 float gain);
+
+/**
+ * Silence all the modes, keeping their settings.
+ */
+void smmodal_reset(struct smmodal *mb);
+
+/**
+ * Excite the modes with x and sum them into y.
+ */
+void smmodal(struct smmodal *mb, int n, float *y, float *x);
+
+#endif /* ! SONICMATHS_MODAL_H */
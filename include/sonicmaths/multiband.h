@@ -0,0 +1,86 @@
+/** @file multiband.h
+ *
+ * Multiband processing, with the bands processed in parallel.
+ *
+ * The input is split into bands of equal width with Linkwitz-Riley
+ * crossovers, as by smf4split(), each band is handed to a callback, and the
+ * results are summed. Each band except the highest is passed through the
+ * allpasses of the crossovers above it before the callback, so that the
+ * bands sum back in phase. The callbacks of different bands run at the same
+ * time on a pool of worker threads and the calling thread.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_MULTIBAND_H
+#define SONICMATHS_MULTIBAND_H 1
+
+#include <pthread.h>
+
+/**
+ * Band callback. Processes the n samples of band in x in place.
+ */
+typedef void smmband_fn(void *arg, int band, int n, float *x);
+
+/**
+ * Multiband processor
+ */
+struct smmband {
+	int nbands; /** The number of bands */
+	int blocklen; /** The maximum block length */
+	float *w_2; /** The prewarped frequency of each crossover point */
+	float *u; /** The crossover state, 6 per crossover point */
+	float *ap; /** The phase compensation state */
+	float *x; /** The band buffers, blocklen each */
+	smmband_fn *fn; /** The band callback */
+	void *arg; /** The argument to fn */
+	int nthreads; /** The number of worker threads */
+	pthread_t *threads; /** The worker threads */
+	pthread_mutex_t lock;
+	pthread_cond_t start; /** Signals a new block to the workers */
+	pthread_cond_t done; /** Signals the end of the block to the caller */
+	unsigned int gen; /** Incremented for each block */
+	int next; /** The next band to be processed */
+	int remaining; /** The number of bands not finished */
+	int n; /** The length of the current block */
+	int quit;
+};
+
+/**
+ * Initialize multiband processor
+ *
+ * The crossover points are at bw, 2 bw, ..., up to the Nyquist frequency;
+ * bw must be positive.
+ * fn is called with arg for each band of each block of at most blocklen
+ * samples, from nthreads worker threads and the calling thread. With
+ * nthreads = 0, everything runs in the calling thread.
+ */
+int smmband_init(struct smmband *mb, float bw, int blocklen, int nthreads,
+		 smmband_fn *fn, void *arg);
+
+/**
+ * Destroy multiband processor
+ */
+void smmband_destroy(struct smmband *mb);
+
+/**
+ * Process a block. y may be the same buffer as x.
+ */
+void smmband(struct smmband *mb, int n, float *y, float *x);
+
+#endif /* ! SONICMATHS_MULTIBAND_H */
@@ -23,6 +23,7 @@
 #ifndef SONICMATHS_OSCILLATOR_H
 #define SONICMATHS_OSCILLATOR_H 1
 
+#include <stdint.h>
 #include <sonicmaths/math.h>
 
 /**
@@ -50,4 +51,44 @@ static inline float smosc_get_phase(struct smosc *osc) {
 	return (float) osc->t;
 }
 
+/**
+ * Convert a frequency or phase in cycles, with |x| < 1, to 2^-32 cycles.
+ *
+ * The result wraps, so negative values come out as the equivalent positive
+ * phase.
+ */
+static inline uint32_t smphasorinc(float x) {
+	return (uint32_t) (int32_t) (x * 2147483648.0f) << 1;
+}
+
+/**
+ * Structure for oscillators with a fixed-point phase
+ *
+ * The phase is kept as an unsigned 32 bit integer, which wraps at the end of
+ * each cycle by itself.
+ */
+struct smphasor {
+	uint32_t t; /** Current phase, in 2^-32 cycles */
+};
+
+/**
+ * Initialize phasor
+ */
+int smphasor_init(struct smphasor *ph);
+
+/**
+ * Destroy phasor
+ */
+void smphasor_destroy(struct smphasor *ph);
+
+static inline void smphasor_set_phase(struct smphasor *ph, float phase) {
+	/* a tiny negative phase rounds up to a whole cycle */
+	phase -= floorf(phase);
+	ph->t = smphasorinc(phase < 1.0f ? phase : 0.0f);
+}
+
+static inline float smphasor_get_phase(struct smphasor *ph) {
+	return (float) ph->t * (1.0f / 4294967296.0f);
+}
+
 #endif /* ! SONICMATHS_SYNTH_H */
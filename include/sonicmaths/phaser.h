@@ -0,0 +1,63 @@
+/** @file phaser.h
+ *
+ * Phaser: a cascade of first order allpasses sharing one cutoff.
+ *
+ * Each stage is the first order allpass low - high of smf1splitv(). All the
+ * stages of a channel share the same coefficient, which is computed once per
+ * sample, and SMV_WIDTH channels are processed at a time, one per lane, as
+ * in filter-bank.h. The output is the allpass alone; mix it with the input
+ * for the notches.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_PHASER_H
+#define SONICMATHS_PHASER_H 1
+
+/**
+ * The maximum number of stages.
+ */
+#define SMPHASER_MAXSTAGES 24
+
+/**
+ * Phaser
+ */
+struct smphaser {
+	int nchannels; /** The number of channels */
+	int nstages; /** The number of allpass stages */
+	float *u; /** The state, grouped by SMV_WIDTH channels */
+};
+
+/**
+ * Initialize phaser
+ *
+ * nstages must be between 1 and SMPHASER_MAXSTAGES.
+ */
+int smphaser_init(struct smphaser *ph, int nchannels, int nstages);
+
+/**
+ * Destroy phaser
+ */
+void smphaser_destroy(struct smphaser *ph);
+
+/**
+ * Run each channel through the allpass cascade, with cutoff f.
+ */
+void smphaser(struct smphaser *ph, int n, float **y, float **x, float **f);
+
+#endif /* ! SONICMATHS_PHASER_H */
@@ -23,16 +23,13 @@
 #ifndef SONICMATHS_REVERB_H
 #define SONICMATHS_REVERB_H 1
 
-struct smverb_delay {
-	int i;
-	float *x;
-};
-
 struct smverb {
-	int ndelays;
-	int delaylen;
-	float *tdist;
-	struct smverb_delay *delays;
+	int ndelays; /** The number of delay lines */
+	int delaylen; /** The length of each line */
+	int stride; /** The distance from one line to the next in x */
+	int i; /** The write position, shared by every line */
+	float *tdist; /** The spread of each line's delay, in tdev */
+	float *x; /** The lines, one after another */
 };
 
 int smverb_init(struct smverb *verb, int delaylen, int ndelays);
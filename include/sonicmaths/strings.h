@@ -0,0 +1,84 @@
+/** @file strings.h
+ *
+ * Plucked strings, as a bank of Karplus-Strong waveguides.
+ *
+ * Each string is a delay loop holding a first order allpass, for the
+ * fraction of a sample, and a one-pole lowpass with a gain, for the losses.
+ * The excitation is added into the loop, and the output is what goes into
+ * the delay. The delays of SMV_WIDTH strings are interleaved in one arena
+ * with one write position, so that each sample of a group of strings is
+ * written at once, and the strings of a group are advanced together a
+ * sample at a time, which their feedback requires, without a call per
+ * sample.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_STRINGS_H
+#define SONICMATHS_STRINGS_H 1
+
+/**
+ * String bank
+ */
+struct smstrings {
+	int nstrings; /** The number of strings */
+	int len; /** The length of each delay, a power of two */
+	int i; /** The write position */
+	float *x; /** The delays, grouped by SMV_WIDTH strings */
+	int *n; /** The whole part of each delay */
+	float *eta; /** The allpass coefficients */
+	float *c; /** The lowpass coefficients */
+	float *rho; /** The loop gains */
+	float *ax1; /** The allpass inputs */
+	float *ay1; /** The allpass outputs */
+	float *ly1; /** The lowpass outputs */
+};
+
+/**
+ * Initialize string bank, for strings down to a frequency of 1 / maxdelay.
+ */
+int smstrings_init(struct smstrings *sb, int nstrings, int maxdelay);
+
+/**
+ * Destroy string bank
+ */
+void smstrings_destroy(struct smstrings *sb);
+
+/**
+ * Tune string k to f, with its amplitude falling by a factor of e every
+ * decay samples, besides what the lowpass takes. brightness, between 0
+ * and 1, is the lowpass coefficient; at 1 the loop is not filtered at all.
+ * The loop length is corrected for the phase delays of the lowpass and the
+ * allpass at f. The tuning is exact for f up to about 0.37; above that the
+ * allpass is kept stable at the cost of pitch, and at 0.5 and above the
+ * loop is as short as it goes.
+ */
+void smstrings_set(struct smstrings *sb, int k, float f, float decay,
+		   float brightness);
+
+/**
+ * Silence string k.
+ */
+void smstrings_reset(struct smstrings *sb, int k);
+
+/**
+ * Excite string k with x[k], with its output in y[k].
+ */
+void smstrings(struct smstrings *sb, int n, float **y, float **x);
+
+#endif /* ! SONICMATHS_STRINGS_H */
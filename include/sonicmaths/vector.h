@@ -0,0 +1,168 @@
+/** @file vector.h
+ *
+ * Vector types for processing several voices, taps or partials at once.
+ *
+ * The width follows the instruction set the library is compiled for: 16
+ * lanes with AVX-512, 8 with AVX and 4 otherwise. Define SMV_WIDTH to
+ * override it.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_VECTOR_H
+#define SONICMATHS_VECTOR_H 1
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef SMV_WIDTH
+# if defined(__AVX512F__)
+#  define SMV_WIDTH 16
+# elif defined(__AVX__)
+#  define SMV_WIDTH 8
+# else
+#  define SMV_WIDTH 4
+# endif
+#endif
+
+typedef float smvf __attribute__((vector_size(SMV_WIDTH * sizeof(float))));
+typedef int32_t smvi
+	__attribute__((vector_size(SMV_WIDTH * sizeof(int32_t))));
+typedef uint32_t smvu
+	__attribute__((vector_size(SMV_WIDTH * sizeof(uint32_t))));
+
+/**
+ * Load a vector from memory which need not be aligned.
+ */
+static inline smvf smvload(const float *x) {
+	smvf v;
+	memcpy(&v, x, sizeof(smvf));
+	return v;
+}
+
+/**
+ * Store a vector to memory which need not be aligned.
+ */
+static inline void smvstore(float *y, smvf v) {
+	memcpy(y, &v, sizeof(smvf));
+}
+
+/**
+ * A vector with every lane set to x.
+ */
+static inline smvf smvdup(float x) {
+	return ((smvf) { 0.0f }) + x;
+}
+
+/**
+ * Choose a where the mask m is set and b elsewhere.
+ */
+static inline smvf smvselect(smvi m, smvf a, smvf b) {
+	return (smvf) ((m & (smvi) a) | (~m & (smvi) b));
+}
+
+/**
+ * Sum of the lanes.
+ */
+static inline float smvsum(smvf x) {
+	int i;
+	float s;
+	s = 0.0f;
+	for (i = 0; i < SMV_WIDTH; i++) {
+		s += x[i];
+	}
+	return s;
+}
+
+/**
+ * Absolute value of each lane.
+ */
+static inline smvf smvabs(smvf x) {
+	return (smvf) ((smvi) x & 0x7fffffff);
+}
+
+/**
+ * The magnitude of x with the sign of s.
+ */
+static inline smvf smvcopysign(smvf x, smvf s) {
+	return (smvf) (((smvi) x & 0x7fffffff) | ((smvi) s & INT32_MIN));
+}
+
+/**
+ * Round each lane to the nearest integer, halfway cases away from zero.
+ */
+static inline smvi smvround(smvf x) {
+	return __builtin_convertvector(x + smvcopysign(smvdup(0.5f), x), smvi);
+}
+
+/**
+ * Round each lane down to an integer.
+ */
+static inline smvf smvfloor(smvf x) {
+	smvf t;
+	t = __builtin_convertvector(__builtin_convertvector(x, smvi), smvf);
+	return t - (smvf) ((smvi) smvdup(1.0f) & (t > x));
+}
+
+/**
+ * The vector counterpart of SMFPNORM.
+ */
+static inline smvf smvfpnorm(smvf x) {
+#ifdef SMFPSANITIZE
+	return (smvf) ((smvi) x & (x == x));
+#else
+	return x;
+#endif
+}
+
+/**
+ * The most samples to interleave at a time, so that the buffers for it can
+ * live on the stack whatever the block size.
+ */
+#define SMV_BLOCK 64
+
+/**
+ * Interleave n samples of each of the m arrays in x, starting at sample i,
+ * into px, with m values per sample. Only the first nx arrays are read; the
+ * other lanes, or all of them if x is NULL, are set to z.
+ */
+static inline void smvinterleave(int m, int n, float *px, float **x, int nx,
+				 int i, float z) {
+	int j, l;
+	for (l = 0; l < m; l++) {
+		for (j = 0; j < n; j++) {
+			px[j * m + l] = x != NULL && l < nx ? x[l][i + j] : z;
+		}
+	}
+}
+
+/**
+ * Deinterleave n samples of the first ny of the m lanes in px into the
+ * arrays in y, starting at sample i.
+ */
+static inline void smvdeinterleave(int m, int n, float **y, int ny, int i,
+				   const float *px) {
+	int j, l;
+	for (l = 0; l < ny; l++) {
+		for (j = 0; j < n; j++) {
+			y[l][i + j] = px[j * m + l];
+		}
+	}
+}
+
+#endif /* ! SONICMATHS_VECTOR_H */
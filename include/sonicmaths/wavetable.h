@@ -0,0 +1,72 @@
+/** @file wavetable.h
+ *
+ * Wavetable oscillator, with band-limited mip levels.
+ *
+ * A table is built from one cycle of a waveform. Its harmonics, up to a
+ * quarter of the cycle length, are found by a DFT, and level l holds the
+ * cycle resynthesized with the lowest len / 2^(l + 2) of them. Each sample
+ * reads the level with the most harmonics that stay below Nyquist at f,
+ * with cubic interpolation.
+ *
+ * The levels live in a read-only mapping, which any number of oscillators
+ * can read at once. Given a cache path, the levels are mapped from that
+ * file if it holds the same cycle, and written there otherwise, so that
+ * other processes share the same pages and later runs skip the build.
+ *
+ */
+/*
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SONICMATHS_WAVETABLE_H
+#define SONICMATHS_WAVETABLE_H 1
+
+#include <stddef.h>
+#include <sonicmaths/oscillator.h>
+
+/**
+ * Wavetable
+ */
+struct smwavetable {
+	int len; /** The length of each level, a power of two */
+	int nlevels; /** The number of levels */
+	const float *data; /** The levels, each with guard points */
+	void *map; /** The mapping holding the levels */
+	size_t mapsize; /** The size of the mapping */
+};
+
+/**
+ * Initialize wavetable from len samples of one cycle.
+ *
+ * len must be a power of two, at least 8. If cachepath is not NULL, the
+ * levels are loaded from or saved to that file; failing to save is not an
+ * error.
+ */
+int smwavetable_init(struct smwavetable *wt, int len, const float *cycle,
+		     const char *cachepath);
+
+/**
+ * Destroy wavetable
+ */
+void smwavetable_destroy(struct smwavetable *wt);
+
+/**
+ * Play the wavetable. The table is only read, and may be shared.
+ */
+void smwavetable(const struct smwavetable *wt, struct smosc *osc, int n,
+		 float *y, float *f, float *phi);
+
+#endif /* ! SONICMATHS_WAVETABLE_H */
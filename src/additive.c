@@ -0,0 +1,120 @@
+/*
+ * additive.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/vector.h"
+#include "sonicmaths/cosine.h"
+#include "sonicmaths/additive.h"
+
+#define SMADDITIVE_NGROUPS(n) (((n) + SMV_WIDTH - 1) / SMV_WIDTH)
+
+/* samples summed per pass over the partials */
+#define SMADDITIVE_BLOCK 64
+
+int smadditive_init(struct smadditive *add, int npartials) {
+	int k;
+	size_t size;
+	add->npartials = npartials;
+	size = sizeof(smvf) * SMADDITIVE_NGROUPS(npartials);
+	add->t = aligned_alloc(sizeof(smvf), size);
+	if (add->t == NULL) {
+		goto undo0;
+	}
+	add->ratio = aligned_alloc(sizeof(smvf), size);
+	if (add->ratio == NULL) {
+		goto undo1;
+	}
+	add->amp = aligned_alloc(sizeof(smvf), size);
+	if (add->amp == NULL) {
+		goto undo2;
+	}
+	memset(add->t, 0, size);
+	memset(add->amp, 0, size);
+	for (k = 0; k < SMADDITIVE_NGROUPS(npartials) * SMV_WIDTH; k++) {
+		add->ratio[k] = k < npartials ? (float) (k + 1) : 0.0f;
+	}
+	return 0;
+undo2:
+	free(add->ratio);
+undo1:
+	free(add->t);
+undo0:
+	return -1;
+}
+
+void smadditive_destroy(struct smadditive *add) {
+	free(add->amp);
+	free(add->ratio);
+	free(add->t);
+}
+
+void smadditive(struct smadditive *add, int n, float *y, float *f) {
+	int i, j, k, l, m, ng, cst, any;
+	smvf acc[SMADDITIVE_BLOCK];
+	smvf r, a, x;
+	smvi on;
+	smvu t, inc;
+	ng = SMADDITIVE_NGROUPS(add->npartials);
+	cst = smisconst(n, f);
+	for (i = 0; i < n; i += m) {
+		m = n - i < SMADDITIVE_BLOCK ? n - i : SMADDITIVE_BLOCK;
+		for (j = 0; j < m; j++) {
+			acc[j] = smvdup(0.0f);
+		}
+		for (k = 0; k < ng * SMV_WIDTH; k += SMV_WIDTH) {
+			memcpy(&t, add->t + k, sizeof(t));
+			r = smvload(add->ratio + k);
+			a = smvload(add->amp + k);
+			if (cst) {
+				/* gains and increments hold over the block, and
+				 * groups wholly above Nyquist only advance */
+				x = r * f[i];
+				on = smvabs(x) < 0.5f;
+				inc = smvphasorinc(x);
+				any = 0;
+				for (l = 0; l < SMV_WIDTH; l++) {
+					any |= on[l];
+				}
+				if (!any) {
+					t += (uint32_t) m * inc;
+				} else {
+					a = smvselect(on, a, smvdup(0.0f));
+					for (j = 0; j < m; j++) {
+						acc[j] += a * smvcosq((smvi) t);
+						t += inc;
+					}
+				}
+			} else {
+				for (j = 0; j < m; j++) {
+					x = r * f[i + j];
+					acc[j] += smvselect(smvabs(x) < 0.5f, a,
+							    smvdup(0.0f))
+						* smvcosq((smvi) t);
+					t += smvphasorinc(x);
+				}
+			}
+			memcpy(add->t + k, &t, sizeof(t));
+		}
+		for (j = 0; j < m; j++) {
+			y[i + j] = smvsum(acc[j]);
+		}
+	}
+}
@@ -0,0 +1,310 @@
+/*
+ * band-limited.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <math.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/oscillator.h"
+#include "sonicmaths/integrator.h"
+#include "sonicmaths/impulse-train.h"
+#include "sonicmaths/band-limited.h"
+
+int smblosc_init(struct smblosc *bl) {
+	int r;
+	r = smosc_init(&bl->osc);
+	if (r != 0) {
+		return r;
+	}
+	smintg_init(&bl->intg[0]);
+	smintg_init(&bl->intg[1]);
+	bl->dc[0] = 0.0f;
+	bl->dc[1] = 0.0f;
+	bl->seeded = 0;
+	return 0;
+}
+
+void smblosc_destroy(struct smblosc *bl) {
+	smintg_destroy(&bl->intg[1]);
+	smintg_destroy(&bl->intg[0]);
+	smosc_destroy(&bl->osc);
+}
+
+/* samples per pass while the parameters hold */
+#define SMBLOSC_BLOCK 64
+/* the pole of the DC blocker between the triangle's integrators */
+#define SMBLOSC_DCPOLE 0.999f
+/* below this frequency the state is not seeded; there are too many
+ * harmonics to sum, and the second integrator's gain, 4f / (1 - leak), is
+ * too small for the startup to matter */
+#define SMBLOSC_SEEDFMIN 1e-4f
+
+/*
+ * The DC blocker, with dc holding its last input and output. Each
+ * integrator multiplies DC by 4f / (1 - leak), so without it rounding in
+ * the trains would leave the triangle visibly off centre at high f.
+ */
+static inline float smblosc_dcblock(float *dc, float x) {
+	dc[1] = x - dc[0] + SMBLOSC_DCPOLE * dc[1];
+	dc[0] = x;
+	return dc[1];
+}
+
+/* a = a b, for complex numbers held as pairs */
+static inline void smblosc_cmul(double *a, const double *b) {
+	double r;
+	r = a[0] * b[0] - a[1] * b[1];
+	a[1] = a[0] * b[1] + a[1] * b[0];
+	a[0] = r;
+}
+
+/*
+ * Set the integrators and the DC blocker to their steady state for the
+ * wave starting at phase t, as if it had always been running with f and w.
+ * The trains are sums of cosines, so each harmonic is taken through the
+ * frequency response of each stage, and the past inputs and outputs that
+ * make up their state are summed from them. The harmonics are stepped by
+ * rotation, as smitrain() does.
+ */
+static void smblosc_seed(struct smblosc *bl, double t, float f, float w,
+			 int ntrains) {
+	int k, m, nh;
+	double ha, x, c[2], e[2], z[2], g[2], b[2], d[2], p[2], q[2],
+	       rt[2], rw[2], rf[2], ct[2], cw[2], u0[7], u1[7], o1, y2;
+	static const double wsinc[7] = {
+		SMINTG_WSINC_3, SMINTG_WSINC_2, SMINTG_WSINC_1, SMINTG_WSINC_0,
+		SMINTG_WSINC_1, SMINTG_WSINC_2, SMINTG_WSINC_3
+	};
+	bl->seeded = 1;
+	if (!(f >= SMBLOSC_SEEDFMIN && f < 0.5f)) {
+		return;
+	}
+	ha = 1.0 / (2.0 * (double) f);
+	nh = (int) ha;
+	ha -= (double) nh;
+	for (m = 0; m < 7; m++) {
+		u0[m] = 0.0;
+		u1[m] = 0.0;
+	}
+	o1 = 0.0;
+	y2 = 0.0;
+	/* the steps from one harmonic to the next */
+	rt[0] = cos(2.0 * M_PI * t);
+	rt[1] = sin(2.0 * M_PI * t);
+	rw[0] = cos(2.0 * M_PI * (double) w);
+	rw[1] = -sin(2.0 * M_PI * (double) w);
+	rf[0] = cos(2.0 * M_PI * (double) f);
+	rf[1] = -sin(2.0 * M_PI * (double) f);
+	ct[0] = 1.0;
+	ct[1] = 0.0;
+	cw[0] = 1.0;
+	cw[1] = 0.0;
+	z[0] = 1.0;
+	z[1] = 0.0;
+	for (k = 1; k <= nh; k++) {
+		/* the harmonic at sample 0, e^(2 pi i k t), less that of the
+		 * train at t - w */
+		smblosc_cmul(ct, rt);
+		smblosc_cmul(cw, rw);
+		c[0] = k == nh ? ha * ct[0] : ct[0];
+		c[1] = k == nh ? ha * ct[1] : ct[1];
+		if (ntrains == 2) {
+			e[0] = 1.0 - cw[0];
+			e[1] = -cw[1];
+			smblosc_cmul(c, e);
+		}
+		/* z = e^(-2 pi i k f); the integrator's response is
+		 * 4f sum(wsinc[m] z^m) / (1 - leak z), and the blocker's
+		 * (1 - z) / (1 - pole z) */
+		smblosc_cmul(z, rf);
+		g[0] = wsinc[0];
+		g[1] = 0.0;
+		e[0] = 1.0;
+		e[1] = 0.0;
+		for (m = 1; m < 7; m++) {
+			smblosc_cmul(e, z);
+			g[0] += wsinc[m] * e[0];
+			g[1] += wsinc[m] * e[1];
+		}
+		d[0] = 1.0 - (double) SMINTG_LEAKINESS * z[0];
+		d[1] = -(double) SMINTG_LEAKINESS * z[1];
+		x = 4.0 * (double) f / (d[0] * d[0] + d[1] * d[1]);
+		e[0] = d[0] * x;
+		e[1] = -d[1] * x;
+		smblosc_cmul(g, e);
+		d[0] = 1.0 - (double) SMBLOSC_DCPOLE * z[0];
+		d[1] = -(double) SMBLOSC_DCPOLE * z[1];
+		x = 1.0 / (d[0] * d[0] + d[1] * d[1]);
+		b[0] = ((1.0 - z[0]) * d[0] - z[1] * d[1]) * x;
+		b[1] = (-z[1] * d[0] - (1.0 - z[0]) * d[1]) * x;
+		/* the first integrator's input m samples back, and the
+		 * blocker's output, which is the second's input over 4f */
+		p[0] = c[0];
+		p[1] = c[1];
+		for (m = 1; m < 7; m++) {
+			smblosc_cmul(p, z);
+			u0[m] += 4.0 * (double) f * p[0];
+			q[0] = p[0];
+			q[1] = p[1];
+			smblosc_cmul(q, g);
+			if (m == 1) {
+				o1 += q[0];
+			}
+			smblosc_cmul(q, b);
+			u1[m] += q[0];
+			if (m == 1) {
+				smblosc_cmul(q, g);
+				y2 += q[0];
+			}
+		}
+	}
+	bl->intg[0].x1 = (float) u0[1];
+	bl->intg[0].x2 = (float) u0[2];
+	bl->intg[0].x3 = (float) u0[3];
+	bl->intg[0].x4 = (float) u0[4];
+	bl->intg[0].x5 = (float) u0[5];
+	bl->intg[0].x6 = (float) u0[6];
+	bl->intg[0].y1 = (float) o1;
+	bl->dc[0] = (float) o1;
+	bl->dc[1] = (float) u1[1];
+	bl->intg[1].x1 = (float) (4.0 * (double) f * u1[1]);
+	bl->intg[1].x2 = (float) (4.0 * (double) f * u1[2]);
+	bl->intg[1].x3 = (float) (4.0 * (double) f * u1[3]);
+	bl->intg[1].x4 = (float) (4.0 * (double) f * u1[4]);
+	bl->intg[1].x5 = (float) (4.0 * (double) f * u1[5]);
+	bl->intg[1].x6 = (float) (4.0 * (double) f * u1[6]);
+	bl->intg[1].y1 = (float) y2;
+}
+
+/*
+ * While f, phi and w hold, smitrain() advances the trains by rotation;
+ * they are taken SMBLOSC_BLOCK samples at a time, so that the buffers stay
+ * in cache, and integrated from there.
+ */
+static void smblosc_const(struct smblosc *bl, int n, float *y, float f,
+			  float phi, float w, int ntrains, int nintg) {
+	int i, j, m;
+	float x, fb[SMBLOSC_BLOCK], pb[SMBLOSC_BLOCK], y0[SMBLOSC_BLOCK],
+	      y1[SMBLOSC_BLOCK], dc[2];
+	struct smosc osc;
+	struct smintg s0, s1;
+	s0 = bl->intg[0];
+	s1 = bl->intg[1];
+	dc[0] = bl->dc[0];
+	dc[1] = bl->dc[1];
+	for (j = 0; j < SMBLOSC_BLOCK; j++) {
+		fb[j] = f;
+	}
+	for (i = 0; i < n; i += m) {
+		m = n - i < SMBLOSC_BLOCK ? n - i : SMBLOSC_BLOCK;
+		osc = bl->osc;
+		for (j = 0; j < m; j++) {
+			pb[j] = phi;
+		}
+		smitrain(&bl->osc, m, y0, fb, pb);
+		if (ntrains == 2) {
+			for (j = 0; j < m; j++) {
+				pb[j] = phi - w;
+			}
+			smitrain(&osc, m, y1, fb, pb);
+			for (j = 0; j < m; j++) {
+				y0[j] -= y1[j];
+			}
+		}
+		for (j = 0; j < m; j++) {
+			x = smintgv(&s0, 4.0f * f * y0[j]);
+			if (nintg == 2) {
+				x = smblosc_dcblock(dc, x);
+				x = smintgv(&s1, 4.0f * f * x);
+			}
+			y[i + j] = x;
+		}
+	}
+	s0.y1 = smfprepairv(s0.y1);
+	s1.y1 = smfprepairv(s1.y1);
+	bl->intg[0] = s0;
+	bl->intg[1] = s1;
+	bl->dc[0] = smfprepairv(dc[0]);
+	bl->dc[1] = smfprepairv(dc[1]);
+}
+
+/*
+ * Integrate nintg times the train at phi, less the train at phi - w if
+ * there are two. If w is NULL, w0 is used throughout.
+ */
+static void smblosc(struct smblosc *bl, int n, float *y, float *f,
+		    float *phi, float *w, float w0, int ntrains, int nintg) {
+	int i;
+	double t, tp;
+	float x, dc[2];
+	struct smintg s0, s1;
+	if (!bl->seeded && n > 0) {
+		smblosc_seed(bl, bl->osc.t + (double) phi[0], f[0],
+			     w == NULL ? w0 : w[0], ntrains);
+	}
+	if (smisconst(n, f) && smisconst(n, phi)
+	    && (w == NULL || smisconst(n, w))) {
+		smblosc_const(bl, n, y, f[0], phi[0], w == NULL ? w0 : w[0],
+			      ntrains, nintg);
+		return;
+	}
+	t = bl->osc.t;
+	s0 = bl->intg[0];
+	s1 = bl->intg[1];
+	dc[0] = bl->dc[0];
+	dc[1] = bl->dc[1];
+	for (i = 0; i < n; i++) {
+		tp = t + (double) phi[i];
+		x = smitrainv(tp, f[i]);
+		if (ntrains == 2) {
+			x -= smitrainv(tp - (double) (w == NULL ? w0 : w[i]),
+				       f[i]);
+		}
+		x = smintgv(&s0, 4.0f * f[i] * x);
+		if (nintg == 2) {
+			x = smblosc_dcblock(dc, x);
+			x = smintgv(&s1, 4.0f * f[i] * x);
+		}
+		y[i] = x;
+		t += (double) f[i];
+		t -= floor(t);
+	}
+	s0.y1 = smfprepairv(s0.y1);
+	s1.y1 = smfprepairv(s1.y1);
+	bl->intg[0] = s0;
+	bl->intg[1] = s1;
+	bl->dc[0] = smfprepairv(dc[0]);
+	bl->dc[1] = smfprepairv(dc[1]);
+	bl->osc.t = isfinite(t) ? t : 0.0;
+}
+
+void smsaw(struct smblosc *bl, int n, float *y, float *f, float *phi) {
+	smblosc(bl, n, y, f, phi, NULL, 0.0f, 1, 1);
+}
+
+void smsquare(struct smblosc *bl, int n, float *y, float *f, float *phi) {
+	smblosc(bl, n, y, f, phi, NULL, 0.5f, 2, 1);
+}
+
+void smpulse(struct smblosc *bl, int n, float *y, float *f, float *phi,
+	     float *w) {
+	smblosc(bl, n, y, f, phi, w, 0.0f, 2, 1);
+}
+
+void smtriangle(struct smblosc *bl, int n, float *y, float *f, float *phi) {
+	smblosc(bl, n, y, f, phi, NULL, 0.5f, 2, 2);
+}
@@ -18,6 +18,9 @@
  * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <math.h>
+#include <string.h>
+#include "sonicmaths/fastmath.h"
+#include "sonicmaths/vector.h"
 #include "sonicmaths/oscillator.h"
 #include "sonicmaths/cosine.h"
 
@@ -26,9 +29,31 @@ void smcos(struct smosc *osc, int n, float *y, float *f, float *phi) {
 	double t;
 	t = osc->t;
 	for (i = 0; i < n; i++) {
-		y[i] = cosf(((float) (2 * M_PI)) * (((float) t) + phi[i]));
+		y[i] = smcosv(((float) (2 * M_PI)) * (((float) t) + phi[i]));
 		t += (double) f[i];
 		t -= floor(t);
 	}
 	osc->t = isfinite(t) ? t : 0.0;
 }
+
+void smcosq(struct smphasor *ph, int n, float *y, float *f, float *phi) {
+	int i;
+	uint32_t t, p;
+	smvi x;
+	/* phases first, kept in y, then the cosines SMV_WIDTH at a time */
+	t = ph->t;
+	for (i = 0; i < n; i++) {
+		p = t + smphasorinc(phi[i]);
+		memcpy(y + i, &p, sizeof(p));
+		t += smphasorinc(f[i]);
+	}
+	ph->t = t;
+	for (i = 0; i + SMV_WIDTH <= n; i += SMV_WIDTH) {
+		memcpy(&x, y + i, sizeof(x));
+		smvstore(y + i, smvcosq(x));
+	}
+	for (; i < n; i++) {
+		memcpy(&p, y + i, sizeof(p));
+		y[i] = smcosqv(p);
+	}
+}
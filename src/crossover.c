@@ -0,0 +1,74 @@
+/*
+ * crossover.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/filter.h"
+#include "sonicmaths/crossover.h"
+
+int smxover_init(struct smxover *xover, int maxnbands) {
+	xover->maxnbands = maxnbands;
+	xover->nbands = 0;
+	xover->bw = 0.0f;
+	xover->u = calloc(maxnbands, sizeof(float) * 6);
+	if (xover->u == NULL) {
+		return -1;
+	}
+	xover->w_2 = malloc(sizeof(float) * maxnbands);
+	if (xover->w_2 == NULL) {
+		free(xover->u);
+		return -1;
+	}
+	return 0;
+}
+
+void smxover_destroy(struct smxover *xover) {
+	free(xover->u);
+	free(xover->w_2);
+}
+
+static void smxover_coeff(struct smxover *xover, float bw) {
+	int j;
+	float f;
+	for (j = 0, f = bw; f < 0.5f && j < xover->maxnbands; f += bw, j++) {
+		xover->w_2[j] = smff2w_2(f);
+	}
+	xover->nbands = j;
+	xover->bw = bw;
+}
+
+void smxover(struct smxover *xover, int n, float **y, float *x, float *bw) {
+	int i, j, m;
+	float _bw;
+	for (i = 0; i < n; i += m) {
+		/* find the run of samples with the same bandwidth */
+		_bw = bw[i];
+		for (m = 1; i + m < n && bw[i + m] == _bw; m++);
+		if (_bw != xover->bw) {
+			smxover_coeff(xover, _bw);
+		}
+		memmove(y[0] + i, x + i, sizeof(float) * m);
+		for (j = 0; j < xover->nbands; j++) {
+			smf4linkwitz_riley(xover->u + 6 * j, m, y[j] + i,
+					   y[j + 1] + i, y[j] + i,
+					   xover->w_2[j]);
+		}
+	}
+}
@@ -18,64 +18,381 @@
  * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef __linux__
+# define _GNU_SOURCE /* for memfd_create() */
+#endif
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/vector.h"
 #include "sonicmaths/delay.h"
 
+/* the least power of two at least len */
+static int smdelay_len(int len) {
+	int l;
+	for (l = 1; l < len; l <<= 1) {
+		/* grow */
+	}
+	return l;
+}
+
 int smdelay_init(struct smdelay *delay, int len) {
-	delay->len = len;
+	delay->len = smdelay_len(len);
 	delay->i = 0;
-	delay->x = malloc(sizeof(float) * len);
+	delay->mapsize = 0;
+	delay->interp = SMDELAY_LINEAR;
+	delay->ntaps = 0;
+	delay->y1 = NULL;
+	delay->x = malloc(sizeof(float) * delay->len);
 	if (delay->x == NULL) {
 		return -1;
 	}
-	memset(delay->x, 0, sizeof(float) * len);
+	memset(delay->x, 0, sizeof(float) * delay->len);
 
 	return 0;
 }
 
+/* an empty file of size bytes, which is gone once closed */
+static int smdelay_open(size_t size) {
+	int fd;
+#ifdef MFD_CLOEXEC
+	fd = memfd_create("smdelay", MFD_CLOEXEC);
+#else
+	char name[64];
+	static int count;
+	snprintf(name, sizeof(name), "/smdelay-%ld-%d", (long) getpid(),
+		 __atomic_fetch_add(&count, 1, __ATOMIC_RELAXED));
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd != -1) {
+		shm_unlink(name);
+	}
+#endif
+	if (fd == -1) {
+		return -1;
+	}
+	if (ftruncate(fd, (off_t) size) == -1) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int smdelay_init_mirrored(struct smdelay *delay, int len) {
+	int fd;
+	long page;
+	size_t size;
+	char *p;
+	page = sysconf(_SC_PAGESIZE);
+	if (page <= 0) {
+		goto undo0;
+	}
+	if ((long) len * (long) sizeof(float) < page) {
+		len = (int) (page / (long) sizeof(float));
+	}
+	delay->len = smdelay_len(len);
+	delay->i = 0;
+	delay->interp = SMDELAY_LINEAR;
+	delay->ntaps = 0;
+	delay->y1 = NULL;
+	size = sizeof(float) * (size_t) delay->len;
+	fd = smdelay_open(size);
+	if (fd == -1) {
+		goto undo0;
+	}
+	/* reserve room for both copies, then put the file in each half */
+	p = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+		goto undo1;
+	}
+	if (mmap(p, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0)
+	    == MAP_FAILED
+	    || mmap(p + size, size, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		goto undo2;
+	}
+	close(fd);
+	delay->x = (float *) p;
+	delay->mapsize = size;
+	return 0;
+undo2:
+	munmap(p, 2 * size);
+undo1:
+	close(fd);
+undo0:
+	return -1;
+}
+
 void smdelay_destroy(struct smdelay *delay) {
-	free(delay->x);
+	free(delay->y1);
+	if (delay->mapsize != 0) {
+		munmap(delay->x, 2 * delay->mapsize);
+	} else {
+		free(delay->x);
+	}
+}
+
+/* write n samples of x at di, n being at most len */
+static void smdelay_write(struct smdelay *delay, int di, int n, float *x) {
+	int r;
+	r = delay->len - di;
+	if (r >= n) {
+		memcpy(delay->x + di, x, sizeof(float) * n);
+	} else {
+		memcpy(delay->x + di, x, sizeof(float) * r);
+		memcpy(delay->x, x + r, sizeof(float) * (n - r));
+	}
+}
+
+/* read n samples from ti into y, n being at most len */
+static void smdelay_read(const struct smdelay *delay, int ti, int n,
+			 float *y) {
+	int r;
+	r = delay->len - ti;
+	if (r >= n) {
+		memcpy(y, delay->x + ti, sizeof(float) * n);
+	} else {
+		memcpy(y, delay->x + ti, sizeof(float) * r);
+		memcpy(y + r, delay->x, sizeof(float) * (n - r));
+	}
+}
+
+int smdelay_set_interp(struct smdelay *delay, enum smdelay_interp interp,
+		       int ntaps) {
+	float *y1;
+	if (interp == SMDELAY_ALLPASS && ntaps > delay->ntaps) {
+		y1 = malloc(sizeof(float) * ntaps);
+		if (y1 == NULL) {
+			return -1;
+		}
+		memset(y1, 0, sizeof(float) * ntaps);
+		free(delay->y1);
+		delay->y1 = y1;
+		delay->ntaps = ntaps;
+	}
+	delay->interp = interp;
+	return 0;
+}
+
+/* the samples read before the one at ceil(t), and after the one following
+ * it */
+static int smdelay_reach(enum smdelay_interp interp) {
+	switch (interp) {
+	case SMDELAY_HERMITE:
+	case SMDELAY_LAGRANGE4:
+	case SMDELAY_ALLPASS:
+		return 1;
+	case SMDELAY_LAGRANGE6:
+		return 2;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Interpolate at s, from 0 to 1, between q[2] and q[3], the samples either
+ * side of the delay; q[0] to q[5] are consecutive in time.
+ */
+static inline smvf smdelay_interpv(enum smdelay_interp interp, const smvf *q,
+				   smvf s) {
+	smvf a, b, c, d, e, f, ab, abc, abcd, ef, def, cdef;
+	switch (interp) {
+	case SMDELAY_HERMITE:
+		return q[2] + s * (0.5f * (q[3] - q[1])
+				   + s * (q[1] - 2.5f * q[2] + 2.0f * q[3]
+					  - 0.5f * q[4]
+					  + s * (0.5f * (q[4] - q[1])
+						 + 1.5f * (q[2] - q[3]))));
+	case SMDELAY_LAGRANGE4:
+		/* the distances from s to each point */
+		a = s + 1.0f;
+		c = s - 1.0f;
+		d = s - 2.0f;
+		ab = a * s;
+		return (s * c * d) * (-1.0f / 6.0f) * q[1]
+			+ (a * c * d) * 0.5f * q[2]
+			+ (ab * d) * -0.5f * q[3]
+			+ (ab * c) * (1.0f / 6.0f) * q[4];
+	case SMDELAY_LAGRANGE6:
+		a = s + 2.0f;
+		b = s + 1.0f;
+		c = s;
+		d = s - 1.0f;
+		e = s - 2.0f;
+		f = s - 3.0f;
+		ab = a * b;
+		abc = ab * c;
+		abcd = abc * d;
+		ef = e * f;
+		def = d * ef;
+		cdef = c * def;
+		return (b * cdef) * (-1.0f / 120.0f) * q[0]
+			+ (a * cdef) * (1.0f / 24.0f) * q[1]
+			+ (ab * def) * (-1.0f / 12.0f) * q[2]
+			+ (abc * ef) * (1.0f / 12.0f) * q[3]
+			+ (abcd * f) * (-1.0f / 24.0f) * q[4]
+			+ (abcd * e) * (1.0f / 120.0f) * q[5];
+	default:
+		return q[2] + s * (q[3] - q[2]);
+	}
+}
+
+/*
+ * n samples of one tap at the delays t, or at t[0] if cst, the first
+ * written at di
+ */
+static inline void smtapdelay_tap(struct smdelay *delay,
+				  enum smdelay_interp interp, int di, int n,
+				  float *y, float *t, int cst) {
+	int i, k, l, r, ti, mask;
+	smvi iota, vi;
+	smvf vt, vn, q[6];
+	smvf _y;
+	mask = delay->len - 1;
+	r = smdelay_reach(interp);
+	for (l = 0; l < SMV_WIDTH; l++) {
+		iota[l] = l;
+	}
+	for (k = 0; k < 6; k++) {
+		q[k] = smvdup(0.0f);
+	}
+	vt = smvdup(t[0]);
+	vn = -smvfloor(-vt);
+	vt = vn - vt;
+	if (cst && vt[0] == 0.0f) {
+		/* a whole delay is a copy */
+		smdelay_read(delay, (di - (int) vn[0]) & mask, n, y);
+		return;
+	}
+	for (i = 0; i < n; i += SMV_WIDTH) {
+		if (!cst) {
+			if (i + SMV_WIDTH <= n) {
+				vt = smvload(t + i);
+			} else {
+				for (l = 0; l < SMV_WIDTH; l++) {
+					vt[l] = t[i + l < n ? i + l : n - 1];
+				}
+			}
+			vn = -smvfloor(-vt);
+			vt = vn - vt;
+		}
+		vi = ((di + i + iota) - __builtin_convertvector(vn, smvi))
+			& mask;
+		ti = vi[0];
+		if (cst && delay->mapsize != 0 && ti < r) {
+			ti += delay->len;
+		}
+		if (cst && ti >= r
+		    && (delay->mapsize != 0
+			|| ti + SMV_WIDTH + r < delay->len)) {
+			/* the points are contiguous and do not wrap */
+			for (k = -r; k <= r + 1; k++) {
+				q[2 + k] = smvload(delay->x + ti + k);
+			}
+		} else {
+			for (k = -r; k <= r + 1; k++) {
+				for (l = 0; l < SMV_WIDTH; l++) {
+					q[2 + k][l] =
+						delay->x[(vi[l] + k) & mask];
+				}
+			}
+		}
+		_y = smdelay_interpv(interp, q, vt);
+		if (i + SMV_WIDTH <= n) {
+			smvstore(y + i, _y);
+		} else {
+			for (l = 0; i + l < n; l++) {
+				y[i + l] = _y[l];
+			}
+		}
+	}
+}
+
+/* n samples of one allpass tap with state y1, the first written at di */
+static void smtapdelay_allpass(struct smdelay *delay, float *y1, int di,
+			       int n, float *y, float *t) {
+	int i, ti, tn, mask;
+	float tf, eta, _y;
+	mask = delay->len - 1;
+	_y = *y1;
+	for (i = 0; i < n; i++) {
+		/* the allpass takes between 0.5 and 1.5 samples of the delay */
+		tn = (int) (t[i] - 0.5f);
+		tf = t[i] - (float) tn;
+		eta = (1.0f - tf) / (1.0f + tf);
+		ti = (di + i - tn) & mask;
+		_y = eta * (delay->x[ti] - _y) + delay->x[(ti - 1) & mask];
+		y[i] = _y;
+	}
+	*y1 = smfprepairv(_y);
 }
 
 void smtapdelay(struct smdelay *delay, int n, int ntaps, float **y, float *x,
 		float **t) {
-	int i, j, di, dlen, ti;
-	float tf, tn, _y;
+	int i, j, m, di, o, cst;
+	float tmax;
+	enum smdelay_interp interp;
+	/* write the input ahead of the taps only so far as none of them
+	 * reads what is written */
+	tmax = 0.0f;
+	for (j = 0; j < ntaps; j++) {
+		for (i = 0; i < n; i++) {
+			tmax = t[j][i] > tmax ? t[j][i] : tmax;
+		}
+	}
 	di = delay->i;
-	dlen = delay->len;
-	for (i = 0; i < n; i++) {
-		delay->x[di] = x[i];
+	o = 0;
+	while (o < n) {
+		m = delay->len - (int) ceilf(tmax)
+			- smdelay_reach(delay->interp);
+		if (m > n - o) {
+			m = n - o;
+		} else if (m < 1) {
+			m = 1;
+		}
+		smdelay_write(delay, di, m, x + o);
 		for (j = 0; j < ntaps; j++) {
-			tf = t[j][i];
-			tn = ceilf(tf);
-			tf = tn - tf;
-			ti = ((di + dlen) - (int) tn) % dlen;
-			_y = delay->x[ti];
-			_y += tf * (delay->x[(ti + 1) % dlen] - _y);
-			y[j][i] = _y;
+			interp = delay->interp;
+			if (interp == SMDELAY_ALLPASS) {
+				if (j < delay->ntaps) {
+					smtapdelay_allpass(delay,
+							   delay->y1 + j, di,
+							   m, y[j] + o,
+							   t[j] + o);
+					continue;
+				}
+				interp = SMDELAY_LINEAR;
+			}
+			cst = smisconst(m, t[j] + o);
+			switch (interp) {
+			case SMDELAY_HERMITE:
+				smtapdelay_tap(delay, SMDELAY_HERMITE, di, m,
+					       y[j] + o, t[j] + o, cst);
+				break;
+			case SMDELAY_LAGRANGE4:
+				smtapdelay_tap(delay, SMDELAY_LAGRANGE4, di, m,
+					       y[j] + o, t[j] + o, cst);
+				break;
+			case SMDELAY_LAGRANGE6:
+				smtapdelay_tap(delay, SMDELAY_LAGRANGE6, di, m,
+					       y[j] + o, t[j] + o, cst);
+				break;
+			default:
+				smtapdelay_tap(delay, SMDELAY_LINEAR, di, m,
+					       y[j] + o, t[j] + o, cst);
+				break;
+			}
 		}
-		di = (di + 1) % dlen;
+		di = (di + m) & (delay->len - 1);
+		o += m;
 	}
 	delay->i = di;
 }
 
 void smdelay(struct smdelay *delay, int n, float *y, float *x, float *t) {
-	int i, di, dlen, ti;
-	float tf, tn, _y;
-	di = delay->i;
-	dlen = delay->len;
-	for (i = 0; i < n; i++) {
-		delay->x[di] = x[i];
-		tf = t[i];
-		tn = ceilf(tf);
-		tf = tn - tf;
-		ti = ((di + dlen) - (int) tn) % dlen;
-		_y = delay->x[ti];
-		_y += tf * (delay->x[(ti + 1) % dlen] - _y);
-		y[i] = _y;
-		di = (di + 1) % dlen;
-	}
-	delay->i = di;
+	smtapdelay(delay, n, 1, &y, x, &t);
 }
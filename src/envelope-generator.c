@@ -21,6 +21,7 @@
 #include <string.h>
 #include <math.h>
 #include "sonicmaths/math.h"
+#include "sonicmaths/fastmath.h"
 #include "sonicmaths/envelope-generator.h"
 
 #define CTL_THRESHOLD 0.2f
@@ -71,7 +72,7 @@ void smenvgl(struct smenvg *envg, int n, float *y, float *ctl,
 			y[i++] = _y;
 		} while (i < n);
 		envg->stage = ENVG_ATTACK;
-		envg->y1 = SMFPNORM(y1);
+		envg->y1 = smfprepairv(y1);
 		return;
 	case ENVG_DECAY:
 	decay:
@@ -96,7 +97,7 @@ void smenvgl(struct smenvg *envg, int n, float *y, float *ctl,
 			y[i++] = _y;
 		} while (i < n);
 		envg->stage = ENVG_DECAY;
-		envg->y1 = SMFPNORM(y1);
+		envg->y1 = smfprepairv(y1);
 		return;
 	case ENVG_SUSTAIN:
 	sustain:
@@ -109,7 +110,7 @@ void smenvgl(struct smenvg *envg, int n, float *y, float *ctl,
 			y[i++] = _y;
 		} while (i < n);
 		envg->stage = ENVG_SUSTAIN;
-		envg->y1 = SMFPNORM(y1);
+		envg->y1 = smfprepairv(y1);
 		return;
 	case ENVG_RELEASE:
 	release:
@@ -134,7 +135,7 @@ void smenvgl(struct smenvg *envg, int n, float *y, float *ctl,
 			y[i++] = _y;
 		} while (i < n);
 		envg->stage = ENVG_RELEASE;
-		envg->y1 = SMFPNORM(y1);
+		envg->y1 = smfprepairv(y1);
 		return;
 	case ENVG_FINISHED:
 	default:
@@ -148,7 +149,7 @@ void smenvgl(struct smenvg *envg, int n, float *y, float *ctl,
 			y[i++] = _y;
 		} while (i < n);
 		envg->stage = ENVG_RELEASE;
-		envg->y1 = SMFPNORM(y1);
+		envg->y1 = smfprepairv(y1);
 		return;
 	}
 }
@@ -158,7 +159,7 @@ void smenvgl(struct smenvg *envg, int n, float *y, float *ctl,
 #define ATTACK_MAGIC_ADJ 0.045165705363684115f
 
 static inline float smenvgv(float y1, float x, float T) {
-	return x - expf(((float) -M_PI)/T) * (x - y1);
+	return x - smexpv(((float) -M_PI)/T) * (x - y1);
 }
 
 static inline float smenvg_attackv(float y1, float x, float xo, float T) {
@@ -194,7 +195,7 @@ void smenvg(struct smenvg *envg, int n, float *y, float *ctl,
 			y[i++] = _y;
 		} while (i < n);
 		envg->stage = ENVG_ATTACK;
-		envg->y1 = SMFPNORM(y1);
+		envg->y1 = smfprepairv(y1);
 		return;
 	case ENVG_DECAY:
 	decay:
@@ -213,7 +214,7 @@ void smenvg(struct smenvg *envg, int n, float *y, float *ctl,
 			y[i++] = _y;
 		} while (i < n);
 		envg->stage = ENVG_DECAY;
-		envg->y1 = SMFPNORM(y1);
+		envg->y1 = smfprepairv(y1);
 		return;
 	case ENVG_SUSTAIN:
 	sustain:
@@ -226,7 +227,7 @@ void smenvg(struct smenvg *envg, int n, float *y, float *ctl,
 			y[i++] = _y;
 		} while (i < n);
 		envg->stage = ENVG_SUSTAIN;
-		envg->y1 = SMFPNORM(y1);
+		envg->y1 = smfprepairv(y1);
 		return;
 	case ENVG_RELEASE:
 	release:
@@ -244,7 +245,7 @@ void smenvg(struct smenvg *envg, int n, float *y, float *ctl,
 			y[i++] = _y;
 		} while (i < n);
 		envg->stage = ENVG_RELEASE;
-		envg->y1 = SMFPNORM(y1);
+		envg->y1 = smfprepairv(y1);
 		return;
 	case ENVG_FINISHED:
 	default:
@@ -258,7 +259,7 @@ void smenvg(struct smenvg *envg, int n, float *y, float *ctl,
 			y[i++] = _y;
 		} while (i < n);
 		envg->stage = ENVG_RELEASE;
-		envg->y1 = SMFPNORM(y1);
+		envg->y1 = smfprepairv(y1);
 		return;
 	}
 }
@@ -0,0 +1,482 @@
+/*
+ * filter-bank.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/vector.h"
+#include "sonicmaths/fastmath.h"
+#include "sonicmaths/filter.h"
+#include "sonicmaths/filter-bank.h"
+
+#define SMFBANK_NGROUPS(nvoices) (((nvoices) + SMV_WIDTH - 1) / SMV_WIDTH)
+
+int smfbank_init(struct smfbank *bank, int nvoices) {
+	size_t size;
+	bank->nvoices = nvoices;
+	size = sizeof(smvf) * SMFBANK_NSTATES * SMFBANK_NGROUPS(nvoices);
+	bank->u = aligned_alloc(sizeof(smvf), size);
+	if (bank->u == NULL) {
+		return -1;
+	}
+	memset(bank->u, 0, size);
+	return 0;
+}
+
+void smfbank_destroy(struct smfbank *bank) {
+	free(bank->u);
+}
+
+void smfbank_reset(struct smfbank *bank, int voice) {
+	int k;
+	float *u;
+	u = bank->u + (voice / SMV_WIDTH) * SMFBANK_NSTATES * SMV_WIDTH
+	    + voice % SMV_WIDTH;
+	for (k = 0; k < SMFBANK_NSTATES; k++) {
+		u[k * SMV_WIDTH] = 0.0f;
+	}
+}
+
+/*
+ * The stages of filter.h, SMV_WIDTH voices at a time.
+ */
+
+static inline smvf smfb1g(smvf w_2) {
+	return 1.0f / (1.0f + w_2);
+}
+
+static inline smvf smfb2g(smvf w_2, smvf a) {
+	return 1.0f / (1.0f + a * w_2 + w_2 * w_2);
+}
+
+static inline void smfb1v(smvf *u, smvf x, smvf w_2, smvf g,
+			  smvf *low, smvf *high) {
+	smvf t1, t2;
+	t1 = (x - u[0]) * g;
+	t2 = u[0] + w_2 * t1;
+	u[0] = smvfpnorm(w_2 * t1 + t2);
+	*low = t2;
+	*high = t1;
+}
+
+static inline void smfb2v(smvf *u, smvf x, smvf w_2, smvf a, smvf g,
+			  smvf *low, smvf *band, smvf *high) {
+	smvf t1, t2, t3;
+	t1 = (x - (w_2 + a) * u[0] - u[1]) * g;
+	t2 = u[0] + w_2 * t1;
+	t3 = u[1] + w_2 * t2;
+	u[0] = smvfpnorm(w_2 * t1 + t2);
+	u[1] = smvfpnorm(w_2 * t2 + t3);
+	*low = t3;
+	*band = t2;
+	*high = t1;
+}
+
+/*
+ * A kernel runs one group of voices over the block. All of the buffers are
+ * interleaved, with SMV_WIDTH values per sample; w holds the prewarped
+ * frequency and r the raw resonance. y may be the same as x.
+ */
+typedef void smfbank_kernel(smvf *u, int n, float *y, float *x,
+			    float *w, float *r);
+
+#define LD(p) smvload((p) + i * SMV_WIDTH)
+#define ST(p, v) smvstore((p) + i * SMV_WIDTH, (v))
+
+static void smfbank1low_kernel(smvf *u, int n, float *y, float *x,
+			       float *w, float *r __attribute__((unused))) {
+	int i;
+	smvf w_2, low, high;
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		smfb1v(u, LD(x), w_2, smfb1g(w_2), &low, &high);
+		ST(y, low);
+	}
+}
+
+static void smfbank1high_kernel(smvf *u, int n, float *y, float *x,
+				float *w, float *r __attribute__((unused))) {
+	int i;
+	smvf w_2, low, high;
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		smfb1v(u, LD(x), w_2, smfb1g(w_2), &low, &high);
+		ST(y, high);
+	}
+}
+
+static void smfbank2low_kernel(smvf *u, int n, float *y, float *x,
+			       float *w, float *r) {
+	int i;
+	smvf w_2, a, low, band, high;
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		a = SMF_BWP21 * (1.0f - LD(r));
+		smfb2v(u, LD(x), w_2, a, smfb2g(w_2, a), &low, &band, &high);
+		ST(y, low);
+	}
+}
+
+static void smfbank2high_kernel(smvf *u, int n, float *y, float *x,
+				float *w, float *r) {
+	int i;
+	smvf w_2, a, low, band, high;
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		a = SMF_BWP21 * (1.0f - LD(r));
+		smfb2v(u, LD(x), w_2, a, smfb2g(w_2, a), &low, &band, &high);
+		ST(y, high);
+	}
+}
+
+static void smfbank2band_kernel(smvf *u, int n, float *y, float *x,
+				float *w, float *r) {
+	int i;
+	smvf w_2, a, low, band, high;
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		a = SMF_BWP21 * (1.0f - LD(r));
+		smfb2v(u, LD(x), w_2, a, smfb2g(w_2, a), &low, &band, &high);
+		ST(y, band);
+	}
+}
+
+static void smfbank3low_kernel(smvf *u, int n, float *y, float *x,
+			       float *w, float *r) {
+	int i;
+	smvf w_2, a, t, low, band, high;
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		a = SMF_BWP31 * (1.0f - LD(r));
+		smfb1v(u, LD(x), w_2, smfb1g(w_2), &t, &high);
+		smfb2v(u+1, t, w_2, a, smfb2g(w_2, a), &low, &band, &high);
+		ST(y, low);
+	}
+}
+
+static void smfbank3high_kernel(smvf *u, int n, float *y, float *x,
+				float *w, float *r) {
+	int i;
+	smvf w_2, a, t, low, band, high;
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		a = SMF_BWP31 * (1.0f - LD(r));
+		smfb1v(u, LD(x), w_2, smfb1g(w_2), &low, &t);
+		smfb2v(u+1, t, w_2, a, smfb2g(w_2, a), &low, &band, &high);
+		ST(y, high);
+	}
+}
+
+static void smfbank4low_kernel(smvf *u, int n, float *y, float *x,
+			       float *w, float *r) {
+	int i;
+	smvf w_2, a, b, t, low, band, high;
+	b = smvdup(SMF_BWP42);
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		a = SMF_BWP41 * (1.0f - LD(r));
+		smfb2v(u, LD(x), w_2, b, smfb2g(w_2, b), &t, &band, &high);
+		smfb2v(u+2, t, w_2, a, smfb2g(w_2, a), &low, &band, &high);
+		ST(y, low);
+	}
+}
+
+static void smfbank4high_kernel(smvf *u, int n, float *y, float *x,
+				float *w, float *r) {
+	int i;
+	smvf w_2, a, b, t, low, band, high;
+	b = smvdup(SMF_BWP42);
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		a = SMF_BWP41 * (1.0f - LD(r));
+		smfb2v(u, LD(x), w_2, b, smfb2g(w_2, b), &low, &band, &t);
+		smfb2v(u+2, t, w_2, a, smfb2g(w_2, a), &low, &band, &high);
+		ST(y, high);
+	}
+}
+
+static void smfbank4band_kernel(smvf *u, int n, float *y, float *x,
+				float *w, float *r) {
+	int i;
+	smvf w_2, a, b, t, low, band, high;
+	b = smvdup(SMF_BWP42);
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		a = SMF_BWP41 * (1.0f - LD(r));
+		smfb2v(u, LD(x), w_2, b, smfb2g(w_2, b), &low, &t, &high);
+		smfb2v(u+2, t, w_2, a, smfb2g(w_2, a), &low, &band, &high);
+		ST(y, band);
+	}
+}
+
+static void smfbank6band_kernel(smvf *u, int n, float *y, float *x,
+				float *w, float *r) {
+	int i;
+	smvf w_2, a, b2, b3, t, low, high;
+	b2 = smvdup(SMF_BWP62);
+	b3 = smvdup(SMF_BWP63);
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		a = SMF_BWP61 * (1.0f - LD(r));
+		smfb2v(u, LD(x), w_2, b3, smfb2g(w_2, b3), &low, &t, &high);
+		smfb2v(u+2, t, w_2, b2, smfb2g(w_2, b2), &low, &t, &high);
+		smfb2v(u+4, t, w_2, a, smfb2g(w_2, a), &low, &t, &high);
+		ST(y, t);
+	}
+}
+
+static void smfbank8band_kernel(smvf *u, int n, float *y, float *x,
+				float *w, float *r) {
+	int i;
+	smvf w_2, a, b2, b3, b4, t, low, high;
+	b2 = smvdup(SMF_BWP82);
+	b3 = smvdup(SMF_BWP83);
+	b4 = smvdup(SMF_BWP84);
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		a = SMF_BWP81 * (1.0f - LD(r));
+		smfb2v(u, LD(x), w_2, b4, smfb2g(w_2, b4), &low, &t, &high);
+		smfb2v(u+2, t, w_2, b3, smfb2g(w_2, b3), &low, &t, &high);
+		smfb2v(u+4, t, w_2, b2, smfb2g(w_2, b2), &low, &t, &high);
+		smfb2v(u+6, t, w_2, a, smfb2g(w_2, a), &low, &t, &high);
+		ST(y, t);
+	}
+}
+
+/*
+ * The resonant lowpasses, as in smf3lowres() and smf4lowres().
+ */
+
+static void smfbank3lowres_kernel(smvf *u, int n, float *y, float *x,
+				  float *w, float *r) {
+	int i;
+	smvf t1, t2, t3, t4, t5, t6, w_2, _r, p1, p2, gr;
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		_r = 3.0f * LD(r);
+		p1 = 1.0f + w_2;
+		p2 = 1.0f + SMF_BWP31 * w_2 + w_2 * w_2;
+		gr = 1.0f / (p1 * p2 + w_2 * w_2 * w_2 * _r);
+		t1 = (p1 * p2 * LD(x)
+		      - (w_2 * w_2 * u[0] + p1 * w_2 * u[1]
+			 + p1 * (1.0f + SMF_BWP31 * w_2) * u[2]) * _r) * gr;
+		t2 = (t1 - u[0]) / p1;
+		t3 = u[0] + w_2 * t2;
+		t4 = (t3 - (w_2 + SMF_BWP31) * u[1] - u[2]) / p2;
+		t5 = u[1] + w_2 * t4;
+		t6 = u[2] + w_2 * t5;
+		u[0] = smvfpnorm(w_2 * t2 + t3);
+		u[1] = smvfpnorm(w_2 * t4 + t5);
+		u[2] = smvfpnorm(w_2 * t5 + t6);
+		ST(y, t6);
+	}
+}
+
+static void smfbank4lowres_kernel(smvf *u, int n, float *y, float *x,
+				  float *w, float *r) {
+	int i;
+	smvf t1, t2, t3, t4, t5, t6, t7, w_2, _r, p1, p2, gr;
+	for (i = 0; i < n; i++) {
+		w_2 = LD(w);
+		_r = ((float) M_SQRT2) * LD(r);
+		p1 = 1.0f + SMF_BWP42 * w_2 + w_2 * w_2;
+		p2 = 1.0f + SMF_BWP41 * w_2 + w_2 * w_2;
+		gr = 1.0f / (p1 * p2 + w_2 * w_2 * w_2 * w_2 * _r);
+		t1 = (p1 * p2 * LD(x)
+		      - (w_2 * w_2 * u[0]
+			 + (1.0f + SMF_BWP42 * w_2) * w_2 * w_2 * u[1]
+			 + p1 * w_2 * u[2]
+			 + (1.0f + SMF_BWP41 * w_2) * p1 * u[3]) * _r) * gr;
+		t2 = (t1 - (w_2 + SMF_BWP42) * u[0] - u[1]) / p1;
+		t3 = u[0] + t2 * w_2;
+		t4 = u[1] + t3 * w_2;
+		t5 = (t4 - (w_2 + SMF_BWP41) * u[2] - u[3]) / p2;
+		t6 = u[2] + w_2 * t5;
+		t7 = u[3] + w_2 * t6;
+		u[0] = smvfpnorm(w_2 * t2 + t3);
+		u[1] = smvfpnorm(w_2 * t3 + t4);
+		u[2] = smvfpnorm(w_2 * t5 + t6);
+		u[3] = smvfpnorm(w_2 * t6 + t7);
+		ST(y, t7);
+	}
+}
+
+#undef LD
+#undef ST
+
+static inline smvf smvff2w_2(smvf f) {
+	f = smvselect(f > SMF_FMAX, smvdup(SMF_FMAX), f);
+	f = smvselect(f < SMF_FMIN, smvdup(SMF_FMIN), f);
+	return smvtan(f * (float) M_PI);
+}
+
+/*
+ * With the approximations from fastmath.h a whole group is prewarped at a
+ * time; with libm, one lane at a time, so that constant lanes are only
+ * prewarped once.
+ */
+void smfbank_prewarp(int n, float *w, int *cst) {
+	int i, l;
+#if SMFASTMATH
+	smvf w_2;
+	for (l = 0; l < SMV_WIDTH; l++) {
+		if (!cst[l]) {
+			break;
+		}
+	}
+	if (l == SMV_WIDTH) {
+		w_2 = smvff2w_2(smvload(w));
+		for (i = 0; i < n; i++) {
+			smvstore(w + i * SMV_WIDTH, w_2);
+		}
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		smvstore(w + i * SMV_WIDTH,
+			 smvff2w_2(smvload(w + i * SMV_WIDTH)));
+	}
+#else
+	float w_2;
+	for (l = 0; l < SMV_WIDTH; l++) {
+		if (cst[l]) {
+			w_2 = smff2w_2(w[l]);
+			for (i = 0; i < n; i++) {
+				w[i * SMV_WIDTH + l] = w_2;
+			}
+		} else {
+			for (i = 0; i < n; i++) {
+				w[i * SMV_WIDTH + l]
+					= smff2w_2(w[i * SMV_WIDTH + l]);
+			}
+		}
+	}
+#endif
+}
+
+/*
+ * Interleave the inputs of each group of voices, SMV_BLOCK samples at a
+ * time, run the kernel, and deinterleave the output. Unused lanes in the
+ * last group are fed silence.
+ */
+static void smfbank_run(struct smfbank *bank, int n, float **y, float **x,
+			float **f, float **r, smfbank_kernel *kernel) {
+	int i, m, l, v, nv, cst[SMV_WIDTH];
+	smvf u[SMFBANK_NSTATES];
+	float px[SMV_BLOCK * SMV_WIDTH];
+	float pw[SMV_BLOCK * SMV_WIDTH];
+	float pr[SMV_BLOCK * SMV_WIDTH];
+	if (n <= 0) {
+		return;
+	}
+	for (v = 0; v < bank->nvoices; v += SMV_WIDTH) {
+		nv = bank->nvoices - v;
+		if (nv > SMV_WIDTH) {
+			nv = SMV_WIDTH;
+		}
+		memcpy(u, bank->u + v * SMFBANK_NSTATES, sizeof(u));
+		for (i = 0; i < n; i += m) {
+			m = n - i < SMV_BLOCK ? n - i : SMV_BLOCK;
+			smvinterleave(SMV_WIDTH, m, px, x + v, nv, i, 0.0f);
+			smvinterleave(SMV_WIDTH, m, pw, f + v, nv, i,
+				      SMF_FMIN);
+			smvinterleave(SMV_WIDTH, m, pr,
+				      r != NULL ? r + v : NULL, nv, i, 0.0f);
+			for (l = 0; l < SMV_WIDTH; l++) {
+				cst[l] = l >= nv || smisconst(m, f[v + l] + i);
+			}
+			smfbank_prewarp(m, pw, cst);
+			kernel(u, m, px, px, pw, pr);
+			smvdeinterleave(SMV_WIDTH, m, y + v, nv, i, px);
+		}
+		memcpy(bank->u + v * SMFBANK_NSTATES, u, sizeof(u));
+		smfprepair(bank->u + v * SMFBANK_NSTATES,
+			   SMFBANK_NSTATES * SMV_WIDTH);
+	}
+}
+
+void smfbank1low(struct smfbank *bank, int n, float **y, float **x,
+		 float **f) {
+	smfbank_run(bank, n, y, x, f, NULL, smfbank1low_kernel);
+}
+
+void smfbank1high(struct smfbank *bank, int n, float **y, float **x,
+		  float **f) {
+	smfbank_run(bank, n, y, x, f, NULL, smfbank1high_kernel);
+}
+
+void smfbank2low(struct smfbank *bank, int n, float **y, float **x,
+		 float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank2low_kernel);
+}
+
+void smfbank2high(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank2high_kernel);
+}
+
+void smfbank2band(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank2band_kernel);
+}
+
+void smfbank3low(struct smfbank *bank, int n, float **y, float **x,
+		 float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank3low_kernel);
+}
+
+void smfbank3high(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank3high_kernel);
+}
+
+void smfbank4low(struct smfbank *bank, int n, float **y, float **x,
+		 float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank4low_kernel);
+}
+
+void smfbank4high(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank4high_kernel);
+}
+
+void smfbank4band(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank4band_kernel);
+}
+
+void smfbank6band(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank6band_kernel);
+}
+
+void smfbank8band(struct smfbank *bank, int n, float **y, float **x,
+		  float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank8band_kernel);
+}
+
+void smfbank3lowres(struct smfbank *bank, int n, float **y, float **x,
+		    float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank3lowres_kernel);
+}
+
+void smfbank4lowres(struct smfbank *bank, int n, float **y, float **x,
+		    float **f, float **r) {
+	smfbank_run(bank, n, y, x, f, r, smfbank4lowres_kernel);
+}
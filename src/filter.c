@@ -17,131 +17,495 @@
  * You should have received a copy of the GNU General Public License along
  * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <string.h>
 #include <math.h>
+#include "sonicmaths/vector.h"
 #include "sonicmaths/filter.h"
 
+#if SMFINTERP && (SMFINTERP < 2 || SMFINTERP > 64)
+# error "SMFINTERP should be between 2 and 64"
+#endif
+
+/*
+ * Prewarped frequency for modulated cutoffs. With SMFINTERP, it is computed
+ * exactly only every SMFINTERP samples and at the end of the block, and
+ * ramped linearly in between; otherwise it is exact at every sample.
+ */
+struct smframp {
+	int e; /* index of the next exact value */
+	float w_2; /* current value */
+	float we; /* exact value at e */
+	float dw; /* increment per sample */
+};
+
+static inline float smframpv(struct smframp *s, int i, int n, float *f) {
+#if SMFINTERP
+	if (i == 0) {
+		s->e = 0;
+		s->we = smff2w_2(f[0]);
+	}
+	if (i == s->e) {
+		s->w_2 = s->we;
+		s->e = i + SMFINTERP < n - 1 ? i + SMFINTERP : n - 1;
+		if (s->e > i) {
+			s->we = smff2w_2(f[s->e]);
+			s->dw = (s->we - s->w_2) / (float) (s->e - i);
+		}
+		return s->w_2;
+	}
+	s->w_2 += s->dw;
+	return s->w_2;
+#else
+	(void) s;
+	(void) n;
+	return smff2w_2(f[i]);
+#endif
+}
+
 void smf1low(float *u, int n, float *y, float *x, float *f) {
 	int i;
+	struct smframp ramp;
+	float w_2, g, _u[1];
+	if (smisconst(n, f)) {
+		memcpy(_u, u, sizeof(_u));
+		w_2 = smff2w_2(f[0]);
+		g = smf1g(w_2);
+		for (i = 0; i < n; i++) {
+			y[i] = smf1lowgv(_u, x[i], w_2, g);
+		}
+		smfprepair(_u, 1);
+		memcpy(u, _u, sizeof(_u));
+		return;
+	}
 	for (i = 0; i < n; i++) {
-		y[i] = smf1lowv(u, x[i], smff2w_2(f[i]));
+		y[i] = smf1lowv(u, x[i], smframpv(&ramp, i, n, f));
 	}
+	smfprepair(u, 1);
 }
 
 void smf1high(float *u, int n, float *y, float *x, float *f) {
 	int i;
+	struct smframp ramp;
+	float w_2, g, _u[1];
+	if (smisconst(n, f)) {
+		memcpy(_u, u, sizeof(_u));
+		w_2 = smff2w_2(f[0]);
+		g = smf1g(w_2);
+		for (i = 0; i < n; i++) {
+			y[i] = smf1highgv(_u, x[i], w_2, g);
+		}
+		smfprepair(_u, 1);
+		memcpy(u, _u, sizeof(_u));
+		return;
+	}
 	for (i = 0; i < n; i++) {
-		y[i] = smf1highv(u, x[i], smff2w_2(f[i]));
+		y[i] = smf1highv(u, x[i], smframpv(&ramp, i, n, f));
 	}
+	smfprepair(u, 1);
 }
 
 void smf2low(float *u, int n, float *y, float *x, float *f, float *r) {
 	int i;
+	struct smframp ramp;
+	float w_2, a, g, _u[2];
+	if (smisconst(n, f) && smisconst(n, r)) {
+		memcpy(_u, u, sizeof(_u));
+		w_2 = smff2w_2(f[0]);
+		a = SMF_BWP21 * (1 - r[0]);
+		g = smf2g(w_2, a);
+		for (i = 0; i < n; i++) {
+			y[i] = smf2lowgv(_u, x[i], w_2, a, g);
+		}
+		smfprepair(_u, 2);
+		memcpy(u, _u, sizeof(_u));
+		return;
+	}
 	for (i = 0; i < n; i++) {
-		y[i] = smf2lowv(u, x[i], smff2w_2(f[i]),
+		y[i] = smf2lowv(u, x[i], smframpv(&ramp, i, n, f),
 				SMF_BWP21 * (1 - r[i]));
 	}
+	smfprepair(u, 2);
 }
 
 void smf2high(float *u, int n, float *y, float *x, float *f, float *r) {
 	int i;
+	struct smframp ramp;
+	float w_2, a, g, _u[2];
+	if (smisconst(n, f) && smisconst(n, r)) {
+		memcpy(_u, u, sizeof(_u));
+		w_2 = smff2w_2(f[0]);
+		a = SMF_BWP21 * (1 - r[0]);
+		g = smf2g(w_2, a);
+		for (i = 0; i < n; i++) {
+			y[i] = smf2highgv(_u, x[i], w_2, a, g);
+		}
+		smfprepair(_u, 2);
+		memcpy(u, _u, sizeof(_u));
+		return;
+	}
 	for (i = 0; i < n; i++) {
-		y[i] = smf2highv(u, x[i], smff2w_2(f[i]),
+		y[i] = smf2highv(u, x[i], smframpv(&ramp, i, n, f),
 				 SMF_BWP21 * (1 - r[i]));
 	}
+	smfprepair(u, 2);
 }
 
 void smf2band(float *u, int n, float *y, float *x, float *f, float *r) {
 	int i;
+	struct smframp ramp;
+	float w_2, a, g, _u[2];
+	if (smisconst(n, f) && smisconst(n, r)) {
+		memcpy(_u, u, sizeof(_u));
+		w_2 = smff2w_2(f[0]);
+		a = SMF_BWP21 * (1 - r[0]);
+		g = smf2g(w_2, a);
+		for (i = 0; i < n; i++) {
+			y[i] = smf2bandgv(_u, x[i], w_2, a, g);
+		}
+		smfprepair(_u, 2);
+		memcpy(u, _u, sizeof(_u));
+		return;
+	}
 	for (i = 0; i < n; i++) {
-		y[i] = smf2bandv(u, x[i], smff2w_2(f[i]),
+		y[i] = smf2bandv(u, x[i], smframpv(&ramp, i, n, f),
 				 SMF_BWP21 * (1 - r[i]));
 	}
+	smfprepair(u, 2);
 }
 
-void smf3low(float *u, int n, float *y, float *x, float *f, float *r) {
-	int i;
-	float t, w_2;
-	for (i = 0; i < n; i++) {
-		w_2 = smff2w_2(f[i]);
-		t = smf1lowv(u, x[i], w_2);
-		y[i] = smf2lowv(u+1, t, w_2,
-				SMF_BWP31 * (1 - r[i]));
-	}
+/*
+ * Butterworth cascades, generated from one description per order.
+ *
+ * SMF_BW<N>(X1, X2, XR, p) lists the stages of order N in the order they are
+ * run, each as X(p, offset of its state in u, damping): a first order stage
+ * for odd orders, then the second order stages from the most to the least
+ * damped. The last one, XR, is the one whose damping is scaled by (1 - r).
+ * A bandpass of order N runs the second order stages of order N as
+ * bandpasses.
+ *
+ * SMF_CASCADE(N, p, STAGES) expands to smf<N><p>(), with the coefficient
+ * setup, the constant coefficient loop and the per-sample loop each
+ * unrolled from STAGES, as in smf2low() and friends above.
+ */
+
+#define SMF_BW3(X1, X2, XR, p) X1(p, 0, 0) XR(p, 1, SMF_BWP31)
+#define SMF_BW4(X1, X2, XR, p) X2(p, 0, SMF_BWP42) XR(p, 2, SMF_BWP41)
+#define SMF_BW5(X1, X2, XR, p) X1(p, 0, 0) X2(p, 1, SMF_BWP52)		\
+	XR(p, 3, SMF_BWP51)
+#define SMF_BW6(X1, X2, XR, p) X2(p, 0, SMF_BWP63) X2(p, 2, SMF_BWP62)	\
+	XR(p, 4, SMF_BWP61)
+#define SMF_BW7(X1, X2, XR, p) X1(p, 0, 0) X2(p, 1, SMF_BWP73)		\
+	X2(p, 3, SMF_BWP72) XR(p, 5, SMF_BWP71)
+#define SMF_BW8(X1, X2, XR, p) X2(p, 0, SMF_BWP84) X2(p, 2, SMF_BWP83)	\
+	X2(p, 4, SMF_BWP82) XR(p, 6, SMF_BWP81)
+#define SMF_BW9(X1, X2, XR, p) X1(p, 0, 0) X2(p, 1, SMF_BWP94)		\
+	X2(p, 3, SMF_BWP93) X2(p, 5, SMF_BWP92) XR(p, 7, SMF_BWP91)
+#define SMF_BW10(X1, X2, XR, p) X2(p, 0, SMF_BWP10_5)			\
+	X2(p, 2, SMF_BWP10_4) X2(p, 4, SMF_BWP10_3)			\
+	X2(p, 6, SMF_BWP10_2) XR(p, 8, SMF_BWP10_1)
+#define SMF_BW11(X1, X2, XR, p) X1(p, 0, 0) X2(p, 1, SMF_BWP11_5)	\
+	X2(p, 3, SMF_BWP11_4) X2(p, 5, SMF_BWP11_3)			\
+	X2(p, 7, SMF_BWP11_2) XR(p, 9, SMF_BWP11_1)
+#define SMF_BW12(X1, X2, XR, p) X2(p, 0, SMF_BWP12_6)			\
+	X2(p, 2, SMF_BWP12_5) X2(p, 4, SMF_BWP12_4)			\
+	X2(p, 6, SMF_BWP12_3) X2(p, 8, SMF_BWP12_2)			\
+	XR(p, 10, SMF_BWP12_1)
+#define SMF_BW13(X1, X2, XR, p) X1(p, 0, 0) X2(p, 1, SMF_BWP13_6)	\
+	X2(p, 3, SMF_BWP13_5) X2(p, 5, SMF_BWP13_4)			\
+	X2(p, 7, SMF_BWP13_3) X2(p, 9, SMF_BWP13_2)			\
+	XR(p, 11, SMF_BWP13_1)
+#define SMF_BW14(X1, X2, XR, p) X2(p, 0, SMF_BWP14_7)			\
+	X2(p, 2, SMF_BWP14_6) X2(p, 4, SMF_BWP14_5)			\
+	X2(p, 6, SMF_BWP14_4) X2(p, 8, SMF_BWP14_3)			\
+	X2(p, 10, SMF_BWP14_2) XR(p, 12, SMF_BWP14_1)
+#define SMF_BW15(X1, X2, XR, p) X1(p, 0, 0) X2(p, 1, SMF_BWP15_7)	\
+	X2(p, 3, SMF_BWP15_6) X2(p, 5, SMF_BWP15_5)			\
+	X2(p, 7, SMF_BWP15_4) X2(p, 9, SMF_BWP15_3)			\
+	X2(p, 11, SMF_BWP15_2) XR(p, 13, SMF_BWP15_1)
+#define SMF_BW16(X1, X2, XR, p) X2(p, 0, SMF_BWP16_8)			\
+	X2(p, 2, SMF_BWP16_7) X2(p, 4, SMF_BWP16_6)			\
+	X2(p, 6, SMF_BWP16_5) X2(p, 8, SMF_BWP16_4)			\
+	X2(p, 10, SMF_BWP16_3) X2(p, 12, SMF_BWP16_2)			\
+	XR(p, 14, SMF_BWP16_1)
+
+#define SMF_G1(p, o, c) g[o] = smf1g(w_2);
+#define SMF_G2(p, o, c) g[o] = smf2g(w_2, c);
+#define SMF_GR(p, o, c) a = (c) * (1 - r[0]); g[o] = smf2g(w_2, a);
+#define SMF_C1(p, o, c) t = smf1##p##gv(_u+o, t, w_2, g[o]);
+#define SMF_C2(p, o, c) t = smf2##p##gv(_u+o, t, w_2, c, g[o]);
+#define SMF_CR(p, o, c) t = smf2##p##gv(_u+o, t, w_2, a, g[o]);
+#define SMF_V1(p, o, c) t = smf1##p##v(u+o, t, w_2);
+#define SMF_V2(p, o, c) t = smf2##p##v(u+o, t, w_2, c);
+#define SMF_VR(p, o, c) t = smf2##p##v(u+o, t, w_2, (c) * (1 - r[i]));
+
+#define SMF_CASCADE(N, p, STAGES)					\
+void smf##N##p(float *u, int n, float *y, float *x, float *f,		\
+	       float *r) {						\
+	int i;								\
+	struct smframp ramp;						\
+	float t, w_2, a, g[N], _u[N];					\
+	if (smisconst(n, f) && smisconst(n, r)) {			\
+		memcpy(_u, u, sizeof(_u));				\
+		w_2 = smff2w_2(f[0]);					\
+		STAGES(SMF_G1, SMF_G2, SMF_GR, p)			\
+		for (i = 0; i < n; i++) {				\
+			t = x[i];					\
+			STAGES(SMF_C1, SMF_C2, SMF_CR, p)		\
+			y[i] = t;					\
+		}							\
+		smfprepair(_u, N);					\
+		memcpy(u, _u, sizeof(_u));				\
+		return;							\
+	}								\
+	for (i = 0; i < n; i++) {					\
+		w_2 = smframpv(&ramp, i, n, f);				\
+		t = x[i];						\
+		STAGES(SMF_V1, SMF_V2, SMF_VR, p)			\
+		y[i] = t;						\
+	}								\
+	smfprepair(u, N);						\
 }
 
-void smf3high(float *u, int n, float *y, float *x, float *f, float *r) {
-	int i;
-	float t, w_2;
-	for (i = 0; i < n; i++) {
-		w_2 = smff2w_2(f[i]);
-		t = smf1highv(u, x[i], w_2);
-		y[i] = smf2highv(u+1, t, w_2,
-				 SMF_BWP31 * (1 - r[i]));
-	}
+SMF_CASCADE(3, low, SMF_BW3)
+SMF_CASCADE(3, high, SMF_BW3)
+SMF_CASCADE(4, low, SMF_BW4)
+SMF_CASCADE(4, high, SMF_BW4)
+SMF_CASCADE(4, band, SMF_BW4)
+SMF_CASCADE(5, low, SMF_BW5)
+SMF_CASCADE(5, high, SMF_BW5)
+SMF_CASCADE(6, low, SMF_BW6)
+SMF_CASCADE(6, high, SMF_BW6)
+SMF_CASCADE(6, band, SMF_BW6)
+SMF_CASCADE(7, low, SMF_BW7)
+SMF_CASCADE(7, high, SMF_BW7)
+SMF_CASCADE(8, low, SMF_BW8)
+SMF_CASCADE(8, high, SMF_BW8)
+SMF_CASCADE(8, band, SMF_BW8)
+SMF_CASCADE(9, low, SMF_BW9)
+SMF_CASCADE(9, high, SMF_BW9)
+SMF_CASCADE(10, low, SMF_BW10)
+SMF_CASCADE(10, high, SMF_BW10)
+SMF_CASCADE(10, band, SMF_BW10)
+SMF_CASCADE(11, low, SMF_BW11)
+SMF_CASCADE(11, high, SMF_BW11)
+SMF_CASCADE(12, low, SMF_BW12)
+SMF_CASCADE(12, high, SMF_BW12)
+SMF_CASCADE(12, band, SMF_BW12)
+SMF_CASCADE(13, low, SMF_BW13)
+SMF_CASCADE(13, high, SMF_BW13)
+SMF_CASCADE(14, low, SMF_BW14)
+SMF_CASCADE(14, high, SMF_BW14)
+SMF_CASCADE(14, band, SMF_BW14)
+SMF_CASCADE(15, low, SMF_BW15)
+SMF_CASCADE(15, high, SMF_BW15)
+SMF_CASCADE(16, low, SMF_BW16)
+SMF_CASCADE(16, high, SMF_BW16)
+SMF_CASCADE(16, band, SMF_BW16)
+
+/*
+ * Look-ahead evaluation of a stage with fixed coefficients.
+ *
+ * A stage is linear: with state s and input x, s' = A s + B x and
+ * y = C s + D x. Unrolling that SMV_WIDTH samples ahead, the next
+ * SMV_WIDTH outputs are
+ *
+ *	Y = M s + H X
+ *
+ * where M has rows C A^k and H is lower triangular with the impulse
+ * response on each diagonal, and the state after them is
+ *
+ *	s' = A^SMV_WIDTH s + K X
+ *
+ * where K has columns A^(SMV_WIDTH - 1 - j) B. Rather than derive these
+ * for each kind of stage, they are measured by running the stage itself
+ * from unit states and a unit impulse.
+ */
+typedef float smfla_stage(float *u, float x, float w_2, float a);
+
+struct smflac {
+	smvf m[2]; /* output response to each state */
+	smvf h[SMV_WIDTH]; /* output response to each input */
+	smvf k[2]; /* response of each state to the inputs */
+	float al[2][2]; /* A^SMV_WIDTH */
+};
+
+static float smfla1low(float *u, float x, float w_2, float a) {
+	(void) a;
+	return smf1lowv(u, x, w_2);
 }
 
+static float smfla1high(float *u, float x, float w_2, float a) {
+	(void) a;
+	return smf1highv(u, x, w_2);
+}
 
-void smf4low(float *u, int n, float *y, float *x, float *f, float *r) {
-	int i;
-	float t, w_2;
-	for (i = 0; i < n; i++) {
-		w_2 = smff2w_2(f[i]);
-		t = smf2lowv(u, x[i], w_2, SMF_BWP42);
-		y[i] = smf2lowv(u+2, t, w_2,
-				SMF_BWP41 * (1 - r[i]));
-	}
+static float smfla2low(float *u, float x, float w_2, float a) {
+	return smf2lowv(u, x, w_2, a);
 }
 
-void smf4high(float *u, int n, float *y, float *x, float *f, float *r) {
-	int i;
-	float t, w_2;
-	for (i = 0; i < n; i++) {
-		w_2 = smff2w_2(f[i]);
-		t = smf2highv(u, x[i], w_2, SMF_BWP42);
-		y[i] = smf2highv(u+2, t, w_2,
-				 SMF_BWP41 * (1 - r[i]));
-	}
+static float smfla2high(float *u, float x, float w_2, float a) {
+	return smf2highv(u, x, w_2, a);
 }
 
-void smf4band(float *u, int n, float *y, float *x, float *f, float *r) {
-	int i;
-	float t, w_2;
-	for (i = 0; i < n; i++) {
-		w_2 = smff2w_2(f[i]);
-		t = smf2bandv(u, x[i], w_2, SMF_BWP42);
-		y[i] = smf2bandv(u+2, t, w_2,
-				 SMF_BWP41 * (1 - r[i]));
+static float smfla2band(float *u, float x, float w_2, float a) {
+	return smf2bandv(u, x, w_2, a);
+}
+
+static void smflac_init(struct smflac *c, int ns, smfla_stage *stage,
+			float w_2, float a) {
+	int i, j;
+	float s[2], imp[SMV_WIDTH], k[2][SMV_WIDTH];
+	memset(c, 0, sizeof(struct smflac));
+	for (j = 0; j < ns; j++) {
+		s[0] = s[1] = 0.0f;
+		s[j] = 1.0f;
+		for (i = 0; i < SMV_WIDTH; i++) {
+			c->m[j][i] = stage(s, 0.0f, w_2, a);
+		}
+		c->al[0][j] = s[0];
+		c->al[1][j] = ns > 1 ? s[1] : 0.0f;
+	}
+	s[0] = s[1] = 0.0f;
+	for (i = 0; i < SMV_WIDTH; i++) {
+		imp[i] = stage(s, i == 0 ? 1.0f : 0.0f, w_2, a);
+		k[0][SMV_WIDTH - 1 - i] = s[0];
+		k[1][SMV_WIDTH - 1 - i] = ns > 1 ? s[1] : 0.0f;
+	}
+	for (j = 0; j < SMV_WIDTH; j++) {
+		for (i = j; i < SMV_WIDTH; i++) {
+			c->h[j][i] = imp[i - j];
+		}
+		c->k[0][j] = k[0][j];
+		c->k[1][j] = k[1][j];
 	}
 }
 
-void smf6band(float *u, int n, float *y, float *x, float *f, float *r) {
-	int i;
-	float t, w_2;
-	for (i = 0; i < n; i++) {
-		w_2 = smff2w_2(f[i]);
-		t = smf2bandv(u, x[i], w_2, SMF_BWP63);
-		t = smf2bandv(u+2, t, w_2, SMF_BWP62);
-		y[i] = smf2bandv(u+4, t, w_2,
-				 SMF_BWP61 * (1 - r[i]));
+static void smfla(float *u, int ns, int n, float *y, float *x,
+		  smfla_stage *stage, float w_2, float a) {
+	int i, j;
+	float s[2], s0, s1;
+	smvf X, Y;
+	struct smflac c;
+	smflac_init(&c, ns, stage, w_2, a);
+	s[1] = 0.0f;
+	memcpy(s, u, sizeof(float) * ns);
+	for (i = 0; i + SMV_WIDTH <= n; i += SMV_WIDTH) {
+		X = smvload(x + i);
+		Y = s[0] * c.m[0] + s[1] * c.m[1];
+		for (j = 0; j < SMV_WIDTH; j++) {
+			Y += X[j] * c.h[j];
+		}
+		s0 = c.al[0][0] * s[0] + c.al[0][1] * s[1]
+			+ smvsum(c.k[0] * X);
+		s1 = c.al[1][0] * s[0] + c.al[1][1] * s[1]
+			+ smvsum(c.k[1] * X);
+		s[0] = s0;
+		s[1] = s1;
+		smvstore(y + i, Y);
+	}
+	for (; i < n; i++) {
+		y[i] = stage(s, x[i], w_2, a);
 	}
+	smfprepair(s, ns);
+	memcpy(u, s, sizeof(float) * ns);
+}
+
+void smf2lowla(float *u, int n, float *y, float *x, float f, float r) {
+	smfla(u, 2, n, y, x, smfla2low, smff2w_2(f), SMF_BWP21 * (1 - r));
+}
+
+void smf2highla(float *u, int n, float *y, float *x, float f, float r) {
+	smfla(u, 2, n, y, x, smfla2high, smff2w_2(f), SMF_BWP21 * (1 - r));
+}
+
+void smf2bandla(float *u, int n, float *y, float *x, float f, float r) {
+	smfla(u, 2, n, y, x, smfla2band, smff2w_2(f), SMF_BWP21 * (1 - r));
 }
 
-void smf8band(float *u, int n, float *y, float *x, float *f, float *r) {
+/*
+ * Cascades run one stage over the whole block at a time, in place in y
+ * after the first.
+ */
+#define SMF_L1(p, o, c) smfla(u+o, 1, n, y, x, smfla1##p, w_2, 0.0f); x = y;
+#define SMF_L2(p, o, c) smfla(u+o, 2, n, y, x, smfla2##p, w_2, c); x = y;
+#define SMF_LR(p, o, c)							\
+	smfla(u+o, 2, n, y, x, smfla2##p, w_2, (c) * (1 - r)); x = y;
+
+#define SMF_LACASCADE(N, p, STAGES)					\
+void smf##N##p##la(float *u, int n, float *y, float *x, float f,	\
+		   float r) {						\
+	float w_2;							\
+	w_2 = smff2w_2(f);						\
+	STAGES(SMF_L1, SMF_L2, SMF_LR, p)				\
+}
+
+SMF_LACASCADE(3, low, SMF_BW3)
+SMF_LACASCADE(3, high, SMF_BW3)
+SMF_LACASCADE(4, low, SMF_BW4)
+SMF_LACASCADE(4, high, SMF_BW4)
+SMF_LACASCADE(4, band, SMF_BW4)
+SMF_LACASCADE(5, low, SMF_BW5)
+SMF_LACASCADE(5, high, SMF_BW5)
+SMF_LACASCADE(6, low, SMF_BW6)
+SMF_LACASCADE(6, high, SMF_BW6)
+SMF_LACASCADE(6, band, SMF_BW6)
+SMF_LACASCADE(7, low, SMF_BW7)
+SMF_LACASCADE(7, high, SMF_BW7)
+SMF_LACASCADE(8, low, SMF_BW8)
+SMF_LACASCADE(8, high, SMF_BW8)
+SMF_LACASCADE(8, band, SMF_BW8)
+SMF_LACASCADE(9, low, SMF_BW9)
+SMF_LACASCADE(9, high, SMF_BW9)
+SMF_LACASCADE(10, low, SMF_BW10)
+SMF_LACASCADE(10, high, SMF_BW10)
+SMF_LACASCADE(10, band, SMF_BW10)
+SMF_LACASCADE(11, low, SMF_BW11)
+SMF_LACASCADE(11, high, SMF_BW11)
+SMF_LACASCADE(12, low, SMF_BW12)
+SMF_LACASCADE(12, high, SMF_BW12)
+SMF_LACASCADE(12, band, SMF_BW12)
+SMF_LACASCADE(13, low, SMF_BW13)
+SMF_LACASCADE(13, high, SMF_BW13)
+SMF_LACASCADE(14, low, SMF_BW14)
+SMF_LACASCADE(14, high, SMF_BW14)
+SMF_LACASCADE(14, band, SMF_BW14)
+SMF_LACASCADE(15, low, SMF_BW15)
+SMF_LACASCADE(15, high, SMF_BW15)
+SMF_LACASCADE(16, low, SMF_BW16)
+SMF_LACASCADE(16, high, SMF_BW16)
+SMF_LACASCADE(16, band, SMF_BW16)
+
+void smf4linkwitz_riley(float *u, int n, float *low, float *high, float *x,
+			float w_2) {
 	int i;
-	float t, w_2;
+	float t1, t2, g, _u[6];
+	memcpy(_u, u, sizeof(_u));
+	g = smf2g(w_2, SMF_BWP21);
 	for (i = 0; i < n; i++) {
-		w_2 = smff2w_2(f[i]);
-		t = smf2bandv(u, x[i], w_2, SMF_BWP84);
-		t = smf2bandv(u+2, t, w_2, SMF_BWP83);
-		t = smf2bandv(u+4, t, w_2, SMF_BWP82);
-		y[i] = smf2bandv(u+6, t, w_2,
-				 SMF_BWP81 * (1 - r[i]));
+		smf2splitgv(_u, &t1, &t2, x[i], w_2, SMF_BWP21, g);
+		low[i] = smf2lowgv(_u+2, t1, w_2, SMF_BWP21, g);
+		high[i] = smf2highgv(_u+4, t2, w_2, SMF_BWP21, g);
 	}
+	smfprepair(_u, 6);
+	memcpy(u, _u, sizeof(_u));
 }
 
 void smf4split(float *u, int n, float **y, float *x, float *bw) {
-	int i, j;
+	int i, j, m;
 	float f, _bw, t;
+	if (smisconst(n, bw)) {
+		/* Run each band over the whole block in turn. Each band's
+		 * input is left in its own output buffer by the band
+		 * before. */
+		_bw = bw[0];
+		memmove(y[0], x, sizeof(float) * n);
+		for (j = 0, f = _bw; f < 0.5f; f += _bw, j++) {
+			smf4linkwitz_riley(u+6*j, n, y[j], y[j+1], y[j],
+					   smff2w_2(f));
+		}
+		return;
+	}
+	m = 0;
 	for (i = 0; i < n; i++) {
 		_bw = bw[i];
 		t = x[i];
@@ -150,90 +514,141 @@ void smf4split(float *u, int n, float **y, float *x, float *bw) {
 					    smff2w_2(f));
 		}
 		y[j][i] = t;
+		if (j > m) {
+			m = j;
+		}
 	}
+	smfprepair(u, 6 * m);
 }
 
-void smf3lowres(float *u, int n, float *y, float *x, float *f, float *r) {
-	int i;
-	float t1, t2, t3, t4, t5, t6, u1, u2, u3, w_2, _r;
+/*
+ * Coefficients of the resonant lowpass filters. The input is weighted by kx
+ * and the feedback from each state by k[], with the overall denominator
+ * already folded in; g[] are the reciprocal denominators of the stages.
+ */
+struct smflowresc {
+	float w_2;
+	float kx;
+	float k[4];
+	float g[2];
+};
+
+static inline void smf3lowresc(struct smflowresc *c, float w_2, float r) {
+	float p1, p2, _r, gr;
+	_r = 3.0f * r;
+	p1 = 1.0f + w_2;
+	p2 = 1.0f + SMF_BWP31 * w_2 + w_2 * w_2;
+	gr = 1.0f / (p1 * p2 + w_2 * w_2 * w_2 * _r);
+	c->w_2 = w_2;
+	c->kx = p1 * p2 * gr;
+	c->k[0] = w_2 * w_2 * _r * gr;
+	c->k[1] = p1 * w_2 * _r * gr;
+	c->k[2] = p1 * (1.0f + SMF_BWP31 * w_2) * _r * gr;
+	c->g[0] = 1.0f / p1;
+	c->g[1] = 1.0f / p2;
+}
+
+static inline float smf3lowresv(float *u, float x, struct smflowresc *c) {
+	float t1, t2, t3, t4, t5, t6, u1, u2, u3, w_2;
+	w_2 = c->w_2;
 	u1 = u[0];
 	u2 = u[1];
 	u3 = u[2];
-	for (i = 0; i < n; i++) {
-		w_2 = smff2w_2(f[i]);
-		_r = 3.0f * r[i];
-		t1 = ((1.0f + w_2) * (1.0f + SMF_BWP31 * w_2 + w_2 * w_2) * x[i]
-		      - (w_2 * w_2 * u1 + (1.0f + w_2) * w_2 * u2
-			 + (1.0f + w_2) * (1.0f + SMF_BWP31 * w_2) * u3) * _r)
-		 / /*-----------------------------------------------------------*/
-		     ((1.0f + w_2) * (1.0f + SMF_BWP31 * w_2 + w_2 * w_2)
-		      + w_2 * w_2 * w_2 * _r);
-		t2 = (t1 - u1) / (1.0f + w_2);
-		t3 = u1 + w_2 * t2;
-		t4 = (t3 - (w_2 + SMF_BWP31) * u2 - u3)
-		 / /*------------------------------------*/
-		     (1.0f + SMF_BWP31 * w_2 + w_2 * w_2);
-		t5 = u2 + w_2 * t4;
-		t6 = u3 + w_2 * t5;
-		u1 = w_2 * t2 + t3;
-		u2 = w_2 * t4 + t5;
-		u3 = w_2 * t5 + t6;
-		u1 = SMFPNORM(u1);
-		u2 = SMFPNORM(u2);
-		u3 = SMFPNORM(u3);
-		y[i] = t6;
-	}
-	u[0] = u1;
-	u[1] = u2;
-	u[2] = u3;
+	t1 = c->kx * x - (c->k[0] * u1 + c->k[1] * u2 + c->k[2] * u3);
+	t2 = (t1 - u1) * c->g[0];
+	t3 = u1 + w_2 * t2;
+	t4 = (t3 - (w_2 + SMF_BWP31) * u2 - u3) * c->g[1];
+	t5 = u2 + w_2 * t4;
+	t6 = u3 + w_2 * t5;
+	u1 = w_2 * t2 + t3;
+	u2 = w_2 * t4 + t5;
+	u3 = w_2 * t5 + t6;
+	u[0] = SMFPNORM(u1);
+	u[1] = SMFPNORM(u2);
+	u[2] = SMFPNORM(u3);
+	return t6;
 }
 
-void smf4lowres(float *u, int n, float *y, float *x, float *f, float *r) {
+void smf3lowres(float *u, int n, float *y, float *x, float *f, float *r) {
 	int i;
-	float t1, t2, t3, t4, t5, t6, t7, u1, u2, u3, u4, w_2, _r;
+	struct smframp ramp;
+	float _u[3];
+	struct smflowresc c;
+	memcpy(_u, u, sizeof(_u));
+	if (smisconst(n, f) && smisconst(n, r)) {
+		smf3lowresc(&c, smff2w_2(f[0]), r[0]);
+		for (i = 0; i < n; i++) {
+			y[i] = smf3lowresv(_u, x[i], &c);
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			smf3lowresc(&c, smframpv(&ramp, i, n, f), r[i]);
+			y[i] = smf3lowresv(_u, x[i], &c);
+		}
+	}
+	smfprepair(_u, 3);
+	memcpy(u, _u, sizeof(_u));
+}
+
+static inline void smf4lowresc(struct smflowresc *c, float w_2, float r) {
+	float p1, p2, _r, gr;
+	_r = ((float) M_SQRT2) * r;
+	p1 = 1.0f + SMF_BWP42 * w_2 + w_2 * w_2;
+	p2 = 1.0f + SMF_BWP41 * w_2 + w_2 * w_2;
+	gr = 1.0f / (p1 * p2 + w_2 * w_2 * w_2 * w_2 * _r);
+	c->w_2 = w_2;
+	c->kx = p1 * p2 * gr;
+	c->k[0] = w_2 * w_2 * _r * gr;
+	c->k[1] = (1.0f + SMF_BWP42 * w_2) * w_2 * w_2 * _r * gr;
+	c->k[2] = p1 * w_2 * _r * gr;
+	c->k[3] = (1.0f + SMF_BWP41 * w_2) * p1 * _r * gr;
+	c->g[0] = 1.0f / p1;
+	c->g[1] = 1.0f / p2;
+}
+
+static inline float smf4lowresv(float *u, float x, struct smflowresc *c) {
+	float t1, t2, t3, t4, t5, t6, t7, u1, u2, u3, u4, w_2;
+	w_2 = c->w_2;
 	u1 = u[0];
 	u2 = u[1];
 	u3 = u[2];
 	u4 = u[3];
-	for (i = 0; i < n; i++) {
-		w_2 = smff2w_2(f[i]);
-		_r = ((float) M_SQRT2) * r[i];
-		t1 = ((1 + SMF_BWP42 * w_2 + w_2 * w_2)
-		       * (1 + SMF_BWP41 * w_2 + w_2 * w_2)
-		       * x[i]
-		      - (w_2 * w_2 * u1
-			 + (1.0f + SMF_BWP42 * w_2) * w_2 * w_2 * u2
-			 + (1.0f + SMF_BWP42 * w_2 + w_2 * w_2) * w_2 * u3
-			 + (1.0f + SMF_BWP41 * w_2)
-			   * (1.0f + SMF_BWP42 * w_2 + w_2 * w_2)
-			   * u4)
-		        * _r)
-		  / /*----------------------------------------------------------*/
-		      ((1.0f + SMF_BWP42 * w_2 + w_2 * w_2)
-			* (1.0f + SMF_BWP41 * w_2 + w_2 * w_2)
-		       + w_2 * w_2 * w_2 * w_2 * _r);
-		t2 = (t1 - (w_2 + SMF_BWP42) * u1 - u2)
-		 / /*----------------------------*/
-		     (1.0f + SMF_BWP42 * w_2 + w_2 * w_2);
-		t3 = u1 + t2 * w_2;
-		t4 = u2 + t3 * w_2;
-		t5 = (t4 - (w_2 + SMF_BWP41) * u3 - u4)
-		 / /*----------------------------*/
-		     (1.0f + SMF_BWP41 * w_2 + w_2 * w_2);
-		t6 = u3 + w_2 * t5;
-		t7 = u4 + w_2 * t6;
-		u1 = w_2 * t2 + t3;
-		u2 = w_2 * t3 + t4;
-		u3 = w_2 * t5 + t6;
-		u4 = w_2 * t6 + t7;
-		u1 = SMFPNORM(u1);
-		u2 = SMFPNORM(u2);
-		u3 = SMFPNORM(u3);
-		u4 = SMFPNORM(u4);
-		y[i] = t7;
-	}
-	u[0] = u1;
-	u[1] = u2;
-	u[2] = u3;
-	u[3] = u4;
+	t1 = c->kx * x - (c->k[0] * u1 + c->k[1] * u2
+			  + c->k[2] * u3 + c->k[3] * u4);
+	t2 = (t1 - (w_2 + SMF_BWP42) * u1 - u2) * c->g[0];
+	t3 = u1 + t2 * w_2;
+	t4 = u2 + t3 * w_2;
+	t5 = (t4 - (w_2 + SMF_BWP41) * u3 - u4) * c->g[1];
+	t6 = u3 + w_2 * t5;
+	t7 = u4 + w_2 * t6;
+	u1 = w_2 * t2 + t3;
+	u2 = w_2 * t3 + t4;
+	u3 = w_2 * t5 + t6;
+	u4 = w_2 * t6 + t7;
+	u[0] = SMFPNORM(u1);
+	u[1] = SMFPNORM(u2);
+	u[2] = SMFPNORM(u3);
+	u[3] = SMFPNORM(u4);
+	return t7;
+}
+
+void smf4lowres(float *u, int n, float *y, float *x, float *f, float *r) {
+	int i;
+	struct smframp ramp;
+	float _u[4];
+	struct smflowresc c;
+	memcpy(_u, u, sizeof(_u));
+	if (smisconst(n, f) && smisconst(n, r)) {
+		smf4lowresc(&c, smff2w_2(f[0]), r[0]);
+		for (i = 0; i < n; i++) {
+			y[i] = smf4lowresv(_u, x[i], &c);
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			smf4lowresc(&c, smframpv(&ramp, i, n, f), r[i]);
+			y[i] = smf4lowresv(_u, x[i], &c);
+		}
+	}
+	smfprepair(_u, 4);
+	memcpy(u, _u, sizeof(_u));
 }
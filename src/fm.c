@@ -0,0 +1,191 @@
+/*
+ * fm.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/vector.h"
+#include "sonicmaths/cosine.h"
+#include "sonicmaths/fm.h"
+
+/*
+ * Each operator waits on the ones modulating it, so the kernel works on
+ * SMFM_CHAINS groups of voices at once, to give the processor independent
+ * work to overlap. The groups are allocated in whole kernels' worth; wider
+ * vectors take fewer, so as not to pad small voice counts too much.
+ */
+#define SMFM_CHAINS (SMV_WIDTH < 8 ? 4 : 2)
+
+#define SMFM_KWIDTH (SMFM_CHAINS * SMV_WIDTH)
+
+#define SMFM_NGROUPS(n) (((n) + SMFM_KWIDTH - 1) / SMFM_KWIDTH * SMFM_CHAINS)
+
+int smfm_init(struct smfm *fm, int nvoices, int nops) {
+	int k;
+	size_t size;
+	if (nops < 1 || nops > SMFM_MAXOPS) {
+		goto undo0;
+	}
+	fm->nvoices = nvoices;
+	fm->nops = nops;
+	memset(fm->mod, 0, sizeof(fm->mod));
+	memset(fm->out, 0, sizeof(fm->out));
+	fm->out[0] = 1.0f;
+	size = sizeof(smvf) * nops * SMFM_NGROUPS(nvoices);
+	fm->t = aligned_alloc(sizeof(smvf), size);
+	if (fm->t == NULL) {
+		goto undo0;
+	}
+	fm->ratio = aligned_alloc(sizeof(smvf), size);
+	if (fm->ratio == NULL) {
+		goto undo1;
+	}
+	fm->level = aligned_alloc(sizeof(smvf), size);
+	if (fm->level == NULL) {
+		goto undo2;
+	}
+	fm->y1 = aligned_alloc(sizeof(smvf), size);
+	if (fm->y1 == NULL) {
+		goto undo3;
+	}
+	memset(fm->t, 0, size);
+	memset(fm->y1, 0, size);
+	for (k = 0; k < nops * SMFM_NGROUPS(nvoices) * SMV_WIDTH; k++) {
+		fm->ratio[k] = 1.0f;
+		fm->level[k] = 1.0f;
+	}
+	return 0;
+undo3:
+	free(fm->level);
+undo2:
+	free(fm->ratio);
+undo1:
+	free(fm->t);
+undo0:
+	return -1;
+}
+
+void smfm_destroy(struct smfm *fm) {
+	free(fm->y1);
+	free(fm->level);
+	free(fm->ratio);
+	free(fm->t);
+}
+
+void smfm_reset(struct smfm *fm, int voice) {
+	int k, i;
+	for (k = 0; k < fm->nops; k++) {
+		i = smfm_index(fm, voice, k);
+		fm->t[i] = 0;
+		fm->y1[i] = 0.0f;
+	}
+}
+
+/*
+ * SMFM_CHAINS groups of voices, starting at group g. The nonzero routing
+ * entries are gathered first, so that the operator loop only visits those.
+ */
+static void smfm_kernel(struct smfm *fm, int g, int n, float *y, float *f) {
+	int i, j, k, m, c, nops;
+	int nmod[SMFM_MAXOPS], src[SMFM_MAXOPS][SMFM_MAXOPS];
+	float amt[SMFM_MAXOPS][SMFM_MAXOPS], out[SMFM_MAXOPS];
+	smvu t[SMFM_CHAINS][SMFM_MAXOPS], ph;
+	smvf r[SMFM_CHAINS][SMFM_MAXOPS], l[SMFM_CHAINS][SMFM_MAXOPS],
+	     o[SMFM_CHAINS][SMFM_MAXOPS];
+	smvf _f[SMFM_CHAINS], pm[SMFM_CHAINS], _y[SMFM_CHAINS];
+	nops = fm->nops;
+	for (k = 0; k < nops; k++) {
+		nmod[k] = 0;
+		for (j = 0; j < nops; j++) {
+			if (fm->mod[k][j] != 0.0f) {
+				src[k][nmod[k]] = j;
+				amt[k][nmod[k]] = fm->mod[k][j];
+				nmod[k]++;
+			}
+		}
+		out[k] = fm->out[k];
+		for (c = 0; c < SMFM_CHAINS; c++) {
+			j = ((g + c) * nops + k) * SMV_WIDTH;
+			memcpy(&t[c][k], fm->t + j, sizeof(smvu));
+			r[c][k] = smvload(fm->ratio + j);
+			l[c][k] = smvload(fm->level + j);
+			o[c][k] = smvload(fm->y1 + j);
+		}
+	}
+	for (i = 0; i < n; i++) {
+		for (c = 0; c < SMFM_CHAINS; c++) {
+			_f[c] = smvload(f + (i * SMFM_CHAINS + c) * SMV_WIDTH);
+			_y[c] = smvdup(0.0f);
+		}
+		for (k = nops - 1; k >= 0; k--) {
+			for (c = 0; c < SMFM_CHAINS; c++) {
+				pm[c] = smvdup(0.0f);
+			}
+			for (m = 0; m < nmod[k]; m++) {
+				for (c = 0; c < SMFM_CHAINS; c++) {
+					pm[c] += amt[k][m] * o[c][src[k][m]];
+				}
+			}
+			for (c = 0; c < SMFM_CHAINS; c++) {
+				ph = t[c][k] + smvphasorinc(pm[c]);
+				o[c][k] = l[c][k] * smvcosq((smvi) ph);
+				t[c][k] += smvphasorinc(r[c][k] * _f[c]);
+				_y[c] += out[k] * o[c][k];
+			}
+		}
+		for (c = 0; c < SMFM_CHAINS; c++) {
+			smvstore(y + (i * SMFM_CHAINS + c) * SMV_WIDTH, _y[c]);
+		}
+	}
+	for (c = 0; c < SMFM_CHAINS; c++) {
+		j = (g + c) * nops * SMV_WIDTH;
+		for (k = 0; k < nops; k++) {
+			memcpy(fm->t + j + k * SMV_WIDTH, &t[c][k],
+			       sizeof(smvu));
+			smvstore(fm->y1 + j + k * SMV_WIDTH, o[c][k]);
+		}
+		smfprepair(fm->y1 + j, nops * SMV_WIDTH);
+	}
+}
+
+void smfm(struct smfm *fm, int n, float **y, float **f) {
+	int i, m, g, ng, nv;
+	float py[SMV_BLOCK * SMFM_CHAINS * SMV_WIDTH];
+	float pf[SMV_BLOCK * SMFM_CHAINS * SMV_WIDTH];
+	if (n <= 0) {
+		return;
+	}
+	ng = SMFM_NGROUPS(fm->nvoices);
+	for (g = 0; g < ng; g += SMFM_CHAINS) {
+		/* the chains of a call are adjacent groups, so their voices
+		 * are one run of SMFM_CHAINS * SMV_WIDTH lanes */
+		nv = fm->nvoices - g * SMV_WIDTH;
+		if (nv > SMFM_CHAINS * SMV_WIDTH) {
+			nv = SMFM_CHAINS * SMV_WIDTH;
+		}
+		for (i = 0; i < n; i += m) {
+			m = n - i < SMV_BLOCK ? n - i : SMV_BLOCK;
+			smvinterleave(SMFM_CHAINS * SMV_WIDTH, m, pf,
+				      f + g * SMV_WIDTH, nv, i, 0.0f);
+			smfm_kernel(fm, g, m, py, pf);
+			smvdeinterleave(SMFM_CHAINS * SMV_WIDTH, m,
+					y + g * SMV_WIDTH, nv, i, py);
+		}
+	}
+}
@@ -0,0 +1,277 @@
+/*
+ * granular.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/vector.h"
+#include "sonicmaths/granular.h"
+
+/* points in the table of each window */
+#define SMGRANULAR_WLEN 1024
+#define SMGRANULAR_WSTRIDE (SMGRANULAR_WLEN + 1)
+#define SMGRANULAR_NWINDOWS 3
+/* samples mixed at a time */
+#define SMGRANULAR_BLOCK 64
+
+#define SMGRANULAR_NPAD(n) (((n) + SMV_WIDTH - 1) / SMV_WIDTH * SMV_WIDTH)
+
+static float smgranular_windows[SMGRANULAR_NWINDOWS * SMGRANULAR_WSTRIDE];
+static pthread_once_t smgranular_windows_once = PTHREAD_ONCE_INIT;
+
+static void smgranular_make_windows(void) {
+	int i;
+	double u, v, e;
+	float *hann, *lin, *expo;
+	hann = smgranular_windows + SMGRAIN_HANN * SMGRANULAR_WSTRIDE;
+	lin = smgranular_windows + SMGRAIN_LINEAR * SMGRANULAR_WSTRIDE;
+	expo = smgranular_windows + SMGRAIN_EXPONENTIAL * SMGRANULAR_WSTRIDE;
+	/* what smenvg() has left of a stage at its end */
+	e = exp(-M_PI);
+	for (i = 0; i <= SMGRANULAR_WLEN; i++) {
+		u = (double) i / SMGRANULAR_WLEN;
+		hann[i] = (float) (0.5 - 0.5 * cos(2.0 * M_PI * u));
+		lin[i] = (float) (1.0 - fabs(2.0 * u - 1.0));
+		if (u < 0.5) {
+			v = 2.0 * u;
+			expo[i] = (float) ((1.0 - exp(-M_PI * v)) / (1.0 - e));
+		} else {
+			v = 2.0 * u - 1.0;
+			expo[i] = (float) ((exp(-M_PI * v) - e) / (1.0 - e));
+		}
+	}
+}
+
+/* leave slot k silent for good */
+static void smgranular_clear(struct smgranular *gran, int k) {
+	gran->wait[k] = 0;
+	gran->j[k] = 0;
+	gran->win[k] = 0;
+	gran->u[k] = 0.0f;
+	gran->rate[k] = 0.0f;
+	gran->w[k] = 1.0f;
+	gran->dw[k] = 0.0f;
+	gran->gl[k] = 0.0f;
+	gran->gr[k] = 0.0f;
+}
+
+int smgranular_init(struct smgranular *gran, int maxgrains) {
+	int np;
+	int *ip;
+	float *fp;
+	pthread_once(&smgranular_windows_once, smgranular_make_windows);
+	np = SMGRANULAR_NPAD(maxgrains);
+	gran->maxgrains = maxgrains;
+	ip = aligned_alloc(sizeof(smvf), sizeof(int) * 3 * np);
+	if (ip == NULL) {
+		goto undo0;
+	}
+	fp = aligned_alloc(sizeof(smvf), sizeof(float) * 6 * np);
+	if (fp == NULL) {
+		goto undo1;
+	}
+	gran->wait = ip;
+	gran->j = ip + np;
+	gran->win = ip + 2 * np;
+	gran->u = fp;
+	gran->rate = fp + np;
+	gran->w = fp + 2 * np;
+	gran->dw = fp + 3 * np;
+	gran->gl = fp + 4 * np;
+	gran->gr = fp + 5 * np;
+	smgranular_reset(gran);
+	return 0;
+undo1:
+	free(ip);
+undo0:
+	return -1;
+}
+
+void smgranular_destroy(struct smgranular *gran) {
+	free(gran->u);
+	free(gran->wait);
+}
+
+void smgranular_reset(struct smgranular *gran) {
+	int k;
+	for (k = 0; k < SMGRANULAR_NPAD(gran->maxgrains); k++) {
+		smgranular_clear(gran, k);
+	}
+	gran->ngrains = 0;
+}
+
+int smgranular_add(struct smgranular *gran, int delay, double pos, float rate,
+		   float dur, float pan, float amp, enum smgrain_window win) {
+	int k;
+	double j;
+	float a;
+	if (gran->ngrains >= gran->maxgrains) {
+		return -1;
+	}
+	k = gran->ngrains++;
+	j = floor(pos);
+	gran->wait[k] = delay > 0 ? delay : 0;
+	gran->j[k] = (int) j;
+	gran->u[k] = (float) (pos - j);
+	gran->rate[k] = rate;
+	gran->w[k] = 0.0f;
+	gran->dw[k] = dur > 1.0f ? 1.0f / dur : 1.0f;
+	if ((unsigned int) win >= SMGRANULAR_NWINDOWS) {
+		win = SMGRAIN_HANN;
+	}
+	gran->win[k] = (int) win * SMGRANULAR_WSTRIDE;
+	pan = pan > 1.0f ? 1.0f : pan < -1.0f ? -1.0f : pan;
+	a = (pan + 1.0f) * (float) (M_PI / 4);
+	gran->gl[k] = amp * cosf(a);
+	gran->gr[k] = amp * sinf(a);
+	return 0;
+}
+
+/* mix grains g * SMV_WIDTH to g * SMV_WIDTH + SMV_WIDTH - 1 into accl and
+ * accr */
+static void smgranular_kernel(struct smgranular *gran, int g, int n,
+			      smvf *accl, smvf *accr, const float *src,
+			      int len) {
+	int i, k, l;
+	smvi wait, j, win, on, xi, si;
+	smvf u, rate, w, dw, gl, gr, kf, wp, x, a0, a1, p, pf, t, x0, x1, x2,
+		x3, s;
+	k = g * SMV_WIDTH;
+	memcpy(&wait, gran->wait + k, sizeof(smvi));
+	memcpy(&j, gran->j + k, sizeof(smvi));
+	memcpy(&win, gran->win + k, sizeof(smvi));
+	u = smvload(gran->u + k);
+	rate = smvload(gran->rate + k);
+	w = smvload(gran->w + k);
+	dw = smvload(gran->dw + k);
+	gl = smvload(gran->gl + k);
+	gr = smvload(gran->gr + k);
+	/* skip the group if none of it sounds in this block */
+	for (l = 0; l < SMV_WIDTH; l++) {
+		if (wait[l] < n && w[l] < 1.0f) {
+			break;
+		}
+	}
+	if (l < SMV_WIDTH) {
+		a0 = a1 = x0 = x1 = x2 = x3 = smvdup(0.0f);
+		for (i = 0; i < n; i++) {
+			/* the time since each grain started */
+			kf = (float) i - __builtin_convertvector(wait, smvf);
+			wp = w + kf * dw;
+			on = (kf >= 0.0f) & (wp < 1.0f);
+			kf = smvselect(on, kf, smvdup(0.0f));
+			/* the window */
+			x = smvselect(on, wp, smvdup(0.0f))
+				* (float) SMGRANULAR_WLEN;
+			xi = __builtin_convertvector(x, smvi);
+			x -= __builtin_convertvector(xi, smvf);
+			xi += win;
+			for (l = 0; l < SMV_WIDTH; l++) {
+				a0[l] = smgranular_windows[xi[l]];
+				a1[l] = smgranular_windows[xi[l] + 1];
+			}
+			a0 += x * (a1 - a0);
+			/* the source */
+			p = u + kf * rate;
+			pf = smvfloor(p);
+			t = p - pf;
+			si = __builtin_convertvector(pf, smvi) + j;
+			on &= (si >= 1) & (si < len - 2);
+			si = (si & on) | (~on & 1);
+			for (l = 0; l < SMV_WIDTH; l++) {
+				x0[l] = src[si[l] - 1];
+				x1[l] = src[si[l]];
+				x2[l] = src[si[l] + 1];
+				x3[l] = src[si[l] + 2];
+			}
+			s = x1 + t * (0.5f * (x2 - x0)
+				      + t * (x0 - 2.5f * x1 + 2.0f * x2
+					     - 0.5f * x3
+					     + t * (0.5f * (x3 - x0)
+						    + 1.5f * (x1 - x2))));
+			s = smvselect(on, a0 * s, smvdup(0.0f));
+			accl[i] += s * gl;
+			accr[i] += s * gr;
+		}
+		/* move on the grains that have started */
+		kf = (float) n - __builtin_convertvector(wait, smvf);
+		on = kf > 0.0f;
+		kf = smvselect(on, kf, smvdup(0.0f));
+		w += kf * dw;
+		p = u + kf * rate;
+		pf = smvfloor(p);
+		j += __builtin_convertvector(pf, smvi);
+		u = p - pf;
+		smvstore(gran->w + k, w);
+		smvstore(gran->u + k, u);
+		memcpy(gran->j + k, &j, sizeof(smvi));
+	}
+	wait -= n;
+	wait &= wait > 0;
+	memcpy(gran->wait + k, &wait, sizeof(smvi));
+}
+
+/* drop the grains whose windows have run out */
+static void smgranular_retire(struct smgranular *gran) {
+	int k, m;
+	k = 0;
+	while (k < gran->ngrains) {
+		if (gran->w[k] < 1.0f) {
+			k++;
+			continue;
+		}
+		m = --gran->ngrains;
+		gran->wait[k] = gran->wait[m];
+		gran->j[k] = gran->j[m];
+		gran->win[k] = gran->win[m];
+		gran->u[k] = gran->u[m];
+		gran->rate[k] = gran->rate[m];
+		gran->w[k] = gran->w[m];
+		gran->dw[k] = gran->dw[m];
+		gran->gl[k] = gran->gl[m];
+		gran->gr[k] = gran->gr[m];
+		smgranular_clear(gran, m);
+	}
+}
+
+void smgranular(struct smgranular *gran, int n, float *yl, float *yr,
+		const float *src, int len) {
+	int i, g, m;
+	smvf accl[SMGRANULAR_BLOCK], accr[SMGRANULAR_BLOCK];
+	while (n > 0) {
+		m = n < SMGRANULAR_BLOCK ? n : SMGRANULAR_BLOCK;
+		for (i = 0; i < m; i++) {
+			accl[i] = smvdup(0.0f);
+			accr[i] = smvdup(0.0f);
+		}
+		for (g = 0; g * SMV_WIDTH < gran->ngrains; g++) {
+			smgranular_kernel(gran, g, m, accl, accr, src, len);
+		}
+		for (i = 0; i < m; i++) {
+			yl[i] = smvsum(accl[i]);
+			yr[i] = smvsum(accr[i]);
+		}
+		smgranular_retire(gran);
+		yl += m;
+		yr += m;
+		n -= m;
+	}
+}
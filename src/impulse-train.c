@@ -19,31 +19,249 @@
  */
 
 #include <math.h>
+#include <stdint.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/vector.h"
+#include "sonicmaths/fastmath.h"
 #include "sonicmaths/oscillator.h"
 #include "sonicmaths/impulse-train.h"
 
+/*
+ * While f and phi are constant, sin(wt_2) and sin(nh wt_2) are advanced by
+ * rotating the complex numbers e^(i wt_2) and e^(i nh wt_2), and the
+ * (nh + 1) terms are got from their product. Near the impulses sin(wt_2)
+ * goes to zero and the division magnifies any rounding, so the rotation is
+ * done in double, and is seeded from the phase taken to the nearest impulse
+ * (the train repeats every pi in wt_2). The seeds are recomputed every
+ * SMITRAIN_RESEED samples so that the rounding does not pile up.
+ *
+ * The seeds are only as good as the sin() and cos() they come from, which
+ * under the default flags are the x87's, at float precision. Where
+ * |sin(wt_2)| is below SMITRAIN_NEAR, the ratio of the rotated values would
+ * magnify that error past any use, so those samples are evaluated directly
+ * by smitrainv(), as the modulated path does.
+ */
+#define SMITRAIN_RESEED 64
+#define SMITRAIN_NEAR 0.125
+
+/*
+ * smitrainv() at the phase t, with nh and ha worked out already, from the
+ * approximations in fastmath.h, whose error does not grow with the
+ * argument the way the x87's does; near the impulses all three sines are
+ * of small arguments and keep their relative accuracy.
+ */
+static inline float smitrain_near(double t, float nh, float ha) {
+	float wt_2, sinw_2, cosn1w_2;
+	wt_2 = (float) (M_PI * (t - rint(t)));
+	sinw_2 = smfastsinv(wt_2);
+	cosn1w_2 = smfastcosv((nh + 1.0f) * wt_2);
+	return cosn1w_2 * (sinw_2 != 0.0f ? smfastsinv(nh * wt_2) / sinw_2
+			   : nh)
+		+ ha * (2.0f * cosn1w_2 * cosn1w_2 - 1.0f);
+}
+
+/* the same as smitrain_near(), for SMV_WIDTH phases at a time */
+static inline smvf smitrain_nearv(smvf wt_2, smvf nh, smvf ha) {
+	smvf sinw_2, cosn1w_2, r;
+	sinw_2 = smvfastsin(wt_2);
+	cosn1w_2 = smvfastcos((nh + 1.0f) * wt_2);
+	r = smvselect(sinw_2 != 0.0f, smvfastsin(nh * wt_2) / sinw_2, nh);
+	return cosn1w_2 * r + ha * (2.0f * cosn1w_2 * cosn1w_2 - 1.0f);
+}
+
+static void smitrain_const(struct smosc *osc, int n, float *y, float _f,
+			   float _phi) {
+	int i, j, m;
+	double t, nh, wt_2, dw, c1, s1, cn, sn, a, b, c, d, r, cosn1w_2;
+	float ha;
+	ha = 1.0f / (2.0f * _f);
+	nh = (double) floorf(ha);
+	ha -= (float) nh;
+	nh -= 1.0;
+	dw = M_PI * (double) _f;
+	c1 = cos(dw);
+	s1 = sin(dw);
+	cn = cos(nh * dw);
+	sn = sin(nh * dw);
+	t = osc->t;
+	for (i = 0; i < n; i += m) {
+		m = n - i < SMITRAIN_RESEED ? n - i : SMITRAIN_RESEED;
+		wt_2 = t + (double) _phi;
+		wt_2 = M_PI * (wt_2 - rint(wt_2));
+		a = cos(wt_2);
+		b = sin(wt_2);
+		c = cos(nh * wt_2);
+		d = sin(nh * wt_2);
+		for (j = i; j < i + m; j++) {
+			if (fabs(b) < SMITRAIN_NEAR) {
+				y[j] = smitrain_near(t + (double) _phi
+						     + (double) (j - i)
+						     * (double) _f,
+						     (float) nh, (float) ha);
+			} else {
+				cosn1w_2 = c * a - d * b;
+				r = b != 0.0 ? d / b : nh;
+				y[j] = (float) (cosn1w_2 * r
+						+ (double) ha
+						* (2.0 * cosn1w_2 * cosn1w_2
+						   - 1.0));
+			}
+			r = a * c1 - b * s1;
+			b = a * s1 + b * c1;
+			a = r;
+			r = c * cn - d * sn;
+			d = c * sn + d * cn;
+			c = r;
+		}
+		t += (double) m * (double) _f;
+		t -= floor(t);
+	}
+	osc->t = isfinite(t) ? t : 0.0;
+}
+
 void smitrain(struct smosc *osc, int n, float *y, float *f, float *phi) {
 	int i;
 	double t;
-	float _y, _f, wt_2, nh, ha,
-	      sinw_2, sinnw_2, cosn1w_2, cosn1w;
+	if (smisconst(n, f) && smisconst(n, phi)) {
+		smitrain_const(osc, n, y, f[0], phi[0]);
+		return;
+	}
 	t = osc->t;
 	for (i = 0; i < n; i++) {
-		_f = f[i];
-		ha = 1.0f / (2.0f * _f);
-		nh = floorf(ha); /* the number of harmonics */
-		ha -= nh; /* the strength of the top harmonic */
-		nh -= 1.0f;
-		wt_2 = ((float)  M_PI) * (((float) t) + phi[i]);
-		sinw_2 = sinf(wt_2);
-		sinnw_2 = sinf(nh * wt_2);
-		cosn1w_2 = cosf((nh + 1.0f) * wt_2);
-		cosn1w = 2.0f * cosn1w_2 * cosn1w_2 - 1.0f;
-		_y = cosn1w_2 * sinnw_2 / sinw_2;
-		_y += ha * cosn1w;
-		y[i] = _y;
-		t += (double) _f;
+		y[i] = smitrainv(t + (double) phi[i], f[i]);
+		t += (double) f[i];
 		t -= floor(t);
 	}
 	osc->t = isfinite(t) ? t : 0.0;
 }
+
+typedef double smitrain_vd
+	__attribute__((vector_size(SMV_WIDTH * sizeof(double))));
+typedef int64_t smitrain_vl
+	__attribute__((vector_size(SMV_WIDTH * sizeof(int64_t))));
+
+
+/*
+ * The same as smitrain_const(), for SMV_WIDTH oscillators at a time.
+ */
+static void smitrainbank_const(struct smosc *osc, int nosc, int n,
+			       float **y, float *_f, float *_phi) {
+	int i, j, l, m;
+	double t[SMV_WIDTH], nh[SMV_WIDTH], x;
+	float py[SMITRAIN_RESEED * SMV_WIDTH];
+	smitrain_vd ha, c1, s1, cn, sn, a, b, c, d, r, cosn1w_2, vnh,
+		one;
+	smitrain_vl zero, near;
+	smvf w, fnh, fha;
+	for (l = 0; l < SMV_WIDTH; l++) {
+		ha[l] = (double) (1.0f / (2.0f * _f[l]));
+		nh[l] = floor(ha[l]);
+		ha[l] -= nh[l];
+		nh[l] -= 1.0;
+		x = M_PI * (double) _f[l];
+		c1[l] = cos(x);
+		s1[l] = sin(x);
+		cn[l] = cos(nh[l] * x);
+		sn[l] = sin(nh[l] * x);
+		vnh[l] = nh[l];
+		one[l] = 1.0;
+		fnh[l] = (float) nh[l];
+		fha[l] = (float) ha[l];
+		w[l] = 0.0f;
+		t[l] = l < nosc ? osc[l].t : 0.0;
+	}
+	for (i = 0; i < n; i += m) {
+		m = n - i < SMITRAIN_RESEED ? n - i : SMITRAIN_RESEED;
+		for (l = 0; l < SMV_WIDTH; l++) {
+			x = t[l] + (double) _phi[l];
+			x = M_PI * (x - rint(x));
+			a[l] = cos(x);
+			b[l] = sin(x);
+			c[l] = cos(nh[l] * x);
+			d[l] = sin(nh[l] * x);
+		}
+		for (j = 0; j < m; j++) {
+			cosn1w_2 = c * a - d * b;
+			/* d / b, or nh where b is 0 */
+			zero = b == 0.0;
+			r = d / (smitrain_vd) ((smitrain_vl) b
+					       | (zero & (smitrain_vl) one));
+			r = (smitrain_vd) ((~zero & (smitrain_vl) r)
+					   | (zero & (smitrain_vl) vnh));
+			r = cosn1w_2 * r
+				+ ha * (2.0 * cosn1w_2 * cosn1w_2 - 1.0);
+			smvstore(py + j * SMV_WIDTH,
+				 __builtin_convertvector(r, smvf));
+			near = (b < SMITRAIN_NEAR) & (b > -SMITRAIN_NEAR);
+			for (l = 0; l < SMV_WIDTH; l++) {
+				if (near[l]) {
+					break;
+				}
+			}
+			if (l < SMV_WIDTH) {
+				for (l = 0; l < SMV_WIDTH; l++) {
+					x = t[l] + (double) _phi[l]
+						+ (double) j * (double) _f[l];
+					w[l] = (float) (M_PI * (x - rint(x)));
+				}
+				smvstore(py + j * SMV_WIDTH,
+					 smvselect(__builtin_convertvector(
+							   near, smvi),
+						   smitrain_nearv(w, fnh, fha),
+						   smvload(py
+							   + j * SMV_WIDTH)));
+			}
+			r = a * c1 - b * s1;
+			b = a * s1 + b * c1;
+			a = r;
+			r = c * cn - d * sn;
+			d = c * sn + d * cn;
+			c = r;
+		}
+		for (l = 0; l < nosc; l++) {
+			for (j = 0; j < m; j++) {
+				y[l][i + j] = py[j * SMV_WIDTH + l];
+			}
+		}
+		for (l = 0; l < SMV_WIDTH; l++) {
+			t[l] += (double) m * (double) _f[l];
+			t[l] -= floor(t[l]);
+		}
+	}
+	for (l = 0; l < nosc; l++) {
+		osc[l].t = isfinite(t[l]) ? t[l] : 0.0;
+	}
+}
+
+void smitrainbank(struct smosc *osc, int nosc, int n, float **y, float **f,
+		  float **phi) {
+	int l, v, nv;
+	float _f[SMV_WIDTH], _phi[SMV_WIDTH];
+	if (n <= 0) {
+		return;
+	}
+	for (v = 0; v < nosc; v += SMV_WIDTH) {
+		nv = nosc - v < SMV_WIDTH ? nosc - v : SMV_WIDTH;
+		for (l = 0; l < nv; l++) {
+			if (!smisconst(n, f[v + l])
+			    || !smisconst(n, phi[v + l])) {
+				break;
+			}
+			_f[l] = f[v + l][0];
+			_phi[l] = phi[v + l][0];
+		}
+		if (l < nv) {
+			/* some oscillator is modulated */
+			for (l = 0; l < nv; l++) {
+				smitrain(osc + v + l, n, y[v + l], f[v + l],
+					 phi[v + l]);
+			}
+			continue;
+		}
+		for (; l < SMV_WIDTH; l++) {
+			_f[l] = 0.25f;
+			_phi[l] = 0.25f;
+		}
+		smitrainbank_const(osc + v, nv, n, y + v, _f, _phi);
+	}
+}
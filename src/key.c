@@ -21,6 +21,7 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include "sonicmaths/fastmath.h"
 #include "sonicmaths/key.h"
 
 void smn2f(int n, float *f, float *note, float *root) {
@@ -108,8 +109,8 @@ void smkey(struct smkey *key, int n, float *f, float *note, float *root) {
 		} else {
 			f[n] = ldexpf(root[n]
 				      * key->tuning[ni]
-				      * powf(key->tuning[ni + 1]
-					     / key->tuning[ni], nf),
+				      * smpowv(key->tuning[ni + 1]
+					       / key->tuning[ni], nf),
 				      ne);
 		}
 	}
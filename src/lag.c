@@ -20,6 +20,7 @@
 #include <string.h>
 #include <math.h>
 #include "sonicmaths/math.h"
+#include "sonicmaths/fastmath.h"
 #include "sonicmaths/lag.h"
 
 int smlag_init(struct smlag *lag) {
@@ -52,7 +53,7 @@ void smlag(struct smlag *lag, int n, float *y, float *x, float *t) {
 		y1 = _y;
 		y[i] = _y;
 	}
-	lag->y1 = SMFPNORM(y1);
+	lag->y1 = smfprepairv(y1);
 	lag->x1 = x1;
 	lag->xo = xo;
 }
@@ -64,7 +65,7 @@ void smlage(struct smlag *lag, int n, float *y, float *x, float *t) {
 	for (i = 0; i < n; i++) {
 		_x = x[i];
 		T = t[i];
-		_y = _x - expf(((float) -M_PI)/T) * (_x - y1);
+		_y = _x - smexpv(((float) -M_PI)/T) * (_x - y1);
 		if ((_y <= _x && _x <= y1)
 		    || (_y >= _x && _x >= y1)) {
 			_y = _x;
@@ -72,5 +73,5 @@ void smlage(struct smlag *lag, int n, float *y, float *x, float *t) {
 		y1 = _y;
 		y[i] = _y;
 	}
-	lag->y1 = SMFPNORM(y1);
+	lag->y1 = smfprepairv(y1);
 }
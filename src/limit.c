@@ -18,6 +18,7 @@
  * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <math.h>
+#include "sonicmaths/fastmath.h"
 #include "sonicmaths/limit.h"
 
 void smlimit(enum smlimit_kind kind, int n, float *y, float *x,
@@ -30,24 +31,24 @@ void smlimit(enum smlimit_kind kind, int n, float *y, float *x,
 			_x = x[n];
 			_sharpness = sharpness[n];
 			y[n] = copysignf(1
-					 - logf(expf(_sharpness * (1 - fabsf(_x))) + 1)
-				        /* -------------------------------------------- */
-					 /       logf(expf(_sharpness) + 1), _x);
+					 - smlogv(smexpv(_sharpness * (1 - fabsf(_x))) + 1)
+				        /* ------------------------------------------------ */
+					 /       smlogv(smexpv(_sharpness) + 1), _x);
 		}
 		return;
 	case SMLIMIT_HYP:
 		while (n--) {
 			_x = x[n];
 			_sharpness = sharpness[n];
-			y[n] = _x / powf(powf(fabs(_x), _sharpness) + 1,
-					 1 / _sharpness);
+			y[n] = _x / smpowv(smpowv(fabsf(_x), _sharpness) + 1,
+					   1 / _sharpness);
 		}
 		return;
 	case SMLIMIT_ATAN:
 		while (n--) {
 			_x = x[n];
 			_sharpness = sharpness[n];
-			y[n] = 2 * atanf(_sharpness * _x)
+			y[n] = 2 * smatanv(_sharpness * _x)
 		               / ((float) M_PI);
 		}
 		return;
@@ -0,0 +1,257 @@
+/*
+ * minblep.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/oscillator.h"
+#include "sonicmaths/minblep.h"
+
+/* zero crossings on each side of the sinc */
+#define SMBLEP_ZC 16
+/* the cutoff of the sinc, as a fraction of Nyquist; a little below it, so
+ * that the transition band does not fold back */
+#define SMBLEP_CUTOFF 0.9
+/* the size of the FFT used to find the minimum phase */
+#define SMBLEP_NFFT 16384
+
+#define SMBLEP_TABLELEN (SMBLEP_LEN * SMBLEP_OVERSAMPLE + 2)
+
+/* the band-limited step, less the hard step */
+static float smblep_table[SMBLEP_TABLELEN];
+/* how late the band-limited step is on average, in samples */
+static float smblep_lag;
+static int smblep_table_ok;
+static pthread_once_t smblep_table_once = PTHREAD_ONCE_INIT;
+
+/* in-place radix 2 FFT, inverse if sign is 1, unscaled */
+static void smblep_fft(double *re, double *im, int n, int sign) {
+	int i, j, k, m;
+	double wr, wi, tr, ti, ur, ui, t;
+	for (i = 1, j = 0; i < n; i++) {
+		for (k = n >> 1; j & k; k >>= 1) {
+			j ^= k;
+		}
+		j |= k;
+		if (i < j) {
+			t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+	for (m = 2; m <= n; m <<= 1) {
+		for (k = 0; k < m / 2; k++) {
+			wr = cos(2 * M_PI * k / m);
+			wi = (double) sign * sin(2 * M_PI * k / m);
+			for (i = k; i < n; i += m) {
+				j = i + m / 2;
+				tr = re[j] * wr - im[j] * wi;
+				ti = re[j] * wi + im[j] * wr;
+				ur = re[i];
+				ui = im[i];
+				re[i] = ur + tr;
+				im[i] = ui + ti;
+				re[j] = ur - tr;
+				im[j] = ui - ti;
+			}
+		}
+	}
+}
+
+/*
+ * A Blackman windowed sinc is made minimum phase by folding its real
+ * cepstrum onto positive time, then integrated. The lag is the area
+ * between the hard step and the linear interpolation of the table.
+ */
+static void smblep_make_table(void) {
+	int i, nh;
+	double *re, *im, x, e, s;
+	re = malloc(sizeof(double) * 2 * SMBLEP_NFFT);
+	if (re == NULL) {
+		return;
+	}
+	im = re + SMBLEP_NFFT;
+	nh = SMBLEP_ZC * SMBLEP_OVERSAMPLE;
+	for (i = 0; i < SMBLEP_NFFT; i++) {
+		re[i] = 0.0;
+		im[i] = 0.0;
+	}
+	for (i = 0; i <= 2 * nh; i++) {
+		x = SMBLEP_CUTOFF * M_PI * (double) (i - nh)
+			/ SMBLEP_OVERSAMPLE;
+		re[i] = (i == nh ? 1.0 : sin(x) / x)
+			* (0.42 - 0.5 * cos(M_PI * i / nh)
+			   + 0.08 * cos(2 * M_PI * i / nh));
+	}
+	/* the real cepstrum */
+	smblep_fft(re, im, SMBLEP_NFFT, -1);
+	for (i = 0; i < SMBLEP_NFFT; i++) {
+		re[i] = log(fmax(hypot(re[i], im[i]), 1e-12));
+		im[i] = 0.0;
+	}
+	smblep_fft(re, im, SMBLEP_NFFT, 1);
+	for (i = 0; i < SMBLEP_NFFT; i++) {
+		x = re[i] / SMBLEP_NFFT;
+		re[i] = i == 0 || i == SMBLEP_NFFT / 2 ? x
+			: i < SMBLEP_NFFT / 2 ? 2.0 * x : 0.0;
+		im[i] = 0.0;
+	}
+	/* back to the spectrum, which is now minimum phase, and to time */
+	smblep_fft(re, im, SMBLEP_NFFT, -1);
+	for (i = 0; i < SMBLEP_NFFT; i++) {
+		e = exp(re[i]);
+		x = im[i];
+		re[i] = e * cos(x);
+		im[i] = e * sin(x);
+	}
+	smblep_fft(re, im, SMBLEP_NFFT, 1);
+	s = 0.0;
+	for (i = 0; i < SMBLEP_NFFT; i++) {
+		s += re[i];
+	}
+	x = 0.0;
+	e = 0.0;
+	for (i = 0; i < SMBLEP_TABLELEN; i++) {
+		if (i < SMBLEP_LEN * SMBLEP_OVERSAMPLE) {
+			x += re[i];
+			smblep_table[i] = (float) (x / s - 1.0);
+		} else {
+			smblep_table[i] = 0.0f;
+		}
+		e -= (double) smblep_table[i];
+	}
+	e += 0.5 * (double) smblep_table[0];
+	smblep_lag = (float) (e / SMBLEP_OVERSAMPLE);
+	free(re);
+	smblep_table_ok = 1;
+}
+
+int smblep_init(struct smblep *blep) {
+	pthread_once(&smblep_table_once, smblep_make_table);
+	if (!smblep_table_ok) {
+		return -1;
+	}
+	smosc_init(&blep->osc);
+	blep->sync1 = 0.0f;
+	blep->i = 0;
+	memset(blep->r, 0, sizeof(blep->r));
+	return 0;
+}
+
+void smblep_destroy(struct smblep *blep) {
+	smosc_destroy(&blep->osc);
+}
+
+/* add a jump of d, made since samples before the current one */
+static void smblep_add(struct smblep *blep, float d, float since) {
+	int j, k;
+	float x, u;
+	const float *s;
+	x = since * SMBLEP_OVERSAMPLE;
+	j = (int) x;
+	u = x - (float) j;
+	s = smblep_table + j;
+	for (k = 0; k < SMBLEP_LEN; k++) {
+		blep->r[(blep->i + k) & (SMBLEP_LEN - 1)]
+			+= d * (s[0] + u * (s[1] - s[0]));
+		s += SMBLEP_OVERSAMPLE;
+	}
+}
+
+static inline float smblep_naive(double t, float w, int pulse) {
+	if (pulse) {
+		return t < (double) w ? 2.0f * (1.0f - w) : -2.0f * w;
+	}
+	return 1.0f - 2.0f * (float) t;
+}
+
+/*
+ * Move the phase on by dt, over a span that ends e samples before the
+ * current sample, adding the jumps on the way.
+ */
+static double smblep_span(struct smblep *blep, double t, double dt,
+			  double f, double w, int pulse, float e) {
+	double tn;
+	tn = t + dt;
+	if (pulse && t < w && tn >= w) {
+		smblep_add(blep, -2.0f, (float) ((tn - w) / f) + e);
+	}
+	if (tn >= 1.0) {
+		tn -= 1.0;
+		smblep_add(blep, 2.0f, (float) (tn / f) + e);
+		if (pulse && tn >= w) {
+			smblep_add(blep, -2.0f, (float) ((tn - w) / f) + e);
+		}
+	}
+	return tn;
+}
+
+static void smblep(struct smblep *blep, int n, float *y, float *f, float *w,
+		   float *sync) {
+	int i, pulse;
+	double t;
+	float _w, s, s1, a;
+	pulse = w != NULL;
+	_w = 0.5f;
+	t = blep->osc.t;
+	s1 = blep->sync1;
+	for (i = 0; i < n; i++) {
+		if (pulse) {
+			_w = w[i];
+		}
+		s = sync == NULL ? 0.0f : sync[i];
+		if (s1 < 0.0f && s >= 0.0f) {
+			/* the reset is a of the way from the last sample */
+			a = s1 / (s1 - s);
+			t = smblep_span(blep, t, (double) (a * f[i]),
+					(double) f[i], (double) _w, pulse,
+					1.0f - a);
+			smblep_add(blep, smblep_naive(0.0, _w, pulse)
+					 - smblep_naive(t, _w, pulse),
+				   1.0f - a);
+			t = smblep_span(blep, 0.0, (double) ((1.0f - a) * f[i]),
+					(double) f[i], (double) _w, pulse,
+					0.0f);
+		} else {
+			t = smblep_span(blep, t, (double) f[i], (double) f[i],
+					(double) _w, pulse, 0.0f);
+		}
+		s1 = s;
+		y[i] = smblep_naive(t, _w, pulse) + blep->r[blep->i];
+		if (!pulse) {
+			/* the jumps come late, so the ramp comes early */
+			y[i] += 2.0f * f[i] * smblep_lag;
+		}
+		blep->r[blep->i] = 0.0f;
+		blep->i = (blep->i + 1) & (SMBLEP_LEN - 1);
+	}
+	smfprepair(blep->r, SMBLEP_LEN);
+	blep->sync1 = smfprepairv(s1);
+	blep->osc.t = isfinite(t) ? t : 0.0;
+}
+
+void smblepsaw(struct smblep *blep, int n, float *y, float *f, float *sync) {
+	smblep(blep, n, y, f, NULL, sync);
+}
+
+void smbleppulse(struct smblep *blep, int n, float *y, float *f, float *w,
+		 float *sync) {
+	smblep(blep, n, y, f, w, sync);
+}
@@ -0,0 +1,155 @@
+/*
+ * modal.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/vector.h"
+#include "sonicmaths/filter.h"
+#include "sonicmaths/modal.h"
+
+/*
+ * Each mode waits on its own last sample, so the kernel runs SMMODAL_CHAINS
+ * vectors of modes at once, to give the processor independent work. The
+ * modes are allocated in whole kernels' worth.
+ */
+#define SMMODAL_CHAINS 4
+#define SMMODAL_KWIDTH (SMMODAL_CHAINS * SMV_WIDTH)
+#define SMMODAL_NPAD(n) (((n) + SMMODAL_KWIDTH - 1) / SMMODAL_KWIDTH	\
+			 * SMMODAL_KWIDTH)
+
+/* samples per pass over the modes */
+#define SMMODAL_BLOCK 64
+
+int smmodal_init(struct smmodal *mb, int nmodes) {
+	int k, np;
+	float *p;
+	np = SMMODAL_NPAD(nmodes);
+	p = aligned_alloc(sizeof(smvf), sizeof(float) * 6 * np);
+	if (p == NULL) {
+		return -1;
+	}
+	mb->nmodes = nmodes;
+	mb->w_2 = p;
+	mb->aw = p + np;
+	mb->g = p + 2 * np;
+	mb->s = p + 3 * np;
+	mb->u1 = p + 4 * np;
+	mb->u2 = p + 5 * np;
+	memset(p, 0, sizeof(float) * 6 * np);
+	for (k = 0; k < np; k++) {
+		smmodal_set(mb, k, 0.0f, 1.0f, 0.0f);
+	}
+	return 0;
+}
+
+void smmodal_destroy(struct smmodal *mb) {
+	free(mb->w_2);
+}
+
+void smmodal_set(struct smmodal *mb, int k, float f, float decay,
+		 float gain) {
+	float r, w_2, a, g, th, cth, sth, d, c, h1, h2, u[2];
+	if (!(f > 0.0f && f < 0.5f && decay > 0.0f)) {
+		/* a well behaved filter, with no input */
+		f = 0.25f;
+		decay = 1.0f;
+		gain = 0.0f;
+	}
+	/* the analog pole that the bilinear transform takes to z = r e^(i th),
+	 * (z - 1) / (z + 1), normalized as s^2 + a w s + w^2 */
+	r = smexpv(-1.0f / decay);
+	th = 2.0f * (float) M_PI * f;
+	cth = smcosv(th);
+	sth = smsinv(th);
+	d = 1.0f / (r * r + 2.0f * r * cth + 1.0f);
+	c = (r * r - 1.0f) * d;
+	w_2 = sqrtf(c * c + 4.0f * r * r * sth * sth * d * d);
+	a = -2.0f * c / w_2;
+	g = smf2g(w_2, a);
+	/* after the first sample, the impulse response is
+	 * A r^n cos(th n + phi); find A from the next two */
+	u[0] = 0.0f;
+	u[1] = 0.0f;
+	smf2bandgv(u, 1.0f, w_2, a, g);
+	h1 = smf2bandgv(u, 0.0f, w_2, a, g);
+	h2 = smf2bandgv(u, 0.0f, w_2, a, g);
+	c = (h1 * r * cth - h2) / (r * sth);
+	mb->w_2[k] = w_2;
+	mb->aw[k] = w_2 + a;
+	mb->g[k] = g;
+	mb->s[k] = gain * r / sqrtf(h1 * h1 + c * c);
+}
+
+void smmodal_reset(struct smmodal *mb) {
+	int np;
+	np = SMMODAL_NPAD(mb->nmodes);
+	memset(mb->u1, 0, sizeof(float) * np);
+	memset(mb->u2, 0, sizeof(float) * np);
+}
+
+void smmodal(struct smmodal *mb, int n, float *y, float *x) {
+	int i, j, k, c, m, np;
+	smvf acc[SMMODAL_BLOCK];
+	smvf w_2[SMMODAL_CHAINS], aw[SMMODAL_CHAINS], g[SMMODAL_CHAINS],
+	     s[SMMODAL_CHAINS], u1[SMMODAL_CHAINS], u2[SMMODAL_CHAINS];
+	smvf _x, t1, t2, t3, sum;
+	np = SMMODAL_NPAD(mb->nmodes);
+	for (i = 0; i < n; i += m) {
+		m = n - i < SMMODAL_BLOCK ? n - i : SMMODAL_BLOCK;
+		for (j = 0; j < m; j++) {
+			acc[j] = smvdup(0.0f);
+		}
+		for (k = 0; k < np; k += SMMODAL_KWIDTH) {
+			for (c = 0; c < SMMODAL_CHAINS; c++) {
+				w_2[c] = smvload(mb->w_2 + k + c * SMV_WIDTH);
+				aw[c] = smvload(mb->aw + k + c * SMV_WIDTH);
+				g[c] = smvload(mb->g + k + c * SMV_WIDTH);
+				s[c] = smvload(mb->s + k + c * SMV_WIDTH);
+				u1[c] = smvload(mb->u1 + k + c * SMV_WIDTH);
+				u2[c] = smvload(mb->u2 + k + c * SMV_WIDTH);
+			}
+			for (j = 0; j < m; j++) {
+				_x = smvdup(x[i + j]);
+				sum = smvdup(0.0f);
+				for (c = 0; c < SMMODAL_CHAINS; c++) {
+					/* smf2bandgv() */
+					t1 = (_x * s[c] - aw[c] * u1[c] - u2[c])
+						* g[c];
+					t2 = u1[c] + w_2[c] * t1;
+					t3 = u2[c] + w_2[c] * t2;
+					u1[c] = smvfpnorm(w_2[c] * t1 + t2);
+					u2[c] = smvfpnorm(w_2[c] * t2 + t3);
+					sum += t2;
+				}
+				acc[j] += sum;
+			}
+			for (c = 0; c < SMMODAL_CHAINS; c++) {
+				smvstore(mb->u1 + k + c * SMV_WIDTH, u1[c]);
+				smvstore(mb->u2 + k + c * SMV_WIDTH, u2[c]);
+			}
+		}
+		for (j = 0; j < m; j++) {
+			y[i + j] = smvsum(acc[j]);
+		}
+	}
+	smfprepair(mb->u1, np);
+	smfprepair(mb->u2, np);
+}
@@ -0,0 +1,227 @@
+/*
+ * multiband.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/filter.h"
+#include "sonicmaths/multiband.h"
+
+/* Phase compensation and callback for band j */
+static void smmband_band(struct smmband *mb, int j) {
+	int i, k, n;
+	float w_2, g, *x, _u[2];
+	n = mb->n;
+	x = mb->x + j * mb->blocklen;
+	for (k = j + 1; k < mb->nbands - 1; k++) {
+		memcpy(_u, mb->ap + 2 * (j * (mb->nbands - 1) + k), sizeof(_u));
+		w_2 = mb->w_2[k];
+		g = smf2g(w_2, SMF_BWP21);
+		for (i = 0; i < n; i++) {
+			x[i] = smf2allpassgv(_u, x[i], w_2, SMF_BWP21, g);
+		}
+		smfprepair(_u, 2);
+		memcpy(mb->ap + 2 * (j * (mb->nbands - 1) + k), _u, sizeof(_u));
+	}
+	mb->fn(mb->arg, j, n, x);
+}
+
+/* Process bands until there are none left in this block */
+static void smmband_work(struct smmband *mb) {
+	int j;
+	for (;;) {
+		pthread_mutex_lock(&mb->lock);
+		j = mb->next;
+		if (j < mb->nbands) {
+			mb->next++;
+		}
+		pthread_mutex_unlock(&mb->lock);
+		if (j >= mb->nbands) {
+			return;
+		}
+		smmband_band(mb, j);
+		pthread_mutex_lock(&mb->lock);
+		if (--mb->remaining == 0) {
+			pthread_cond_signal(&mb->done);
+		}
+		pthread_mutex_unlock(&mb->lock);
+	}
+}
+
+static void *smmband_thread(void *arg) {
+	struct smmband *mb = arg;
+	unsigned int gen;
+	pthread_mutex_lock(&mb->lock);
+	gen = mb->gen;
+	for (;;) {
+		while (mb->gen == gen && !mb->quit) {
+			pthread_cond_wait(&mb->start, &mb->lock);
+		}
+		if (mb->quit) {
+			break;
+		}
+		gen = mb->gen;
+		pthread_mutex_unlock(&mb->lock);
+		smmband_work(mb);
+		pthread_mutex_lock(&mb->lock);
+	}
+	pthread_mutex_unlock(&mb->lock);
+	return NULL;
+}
+
+static void smmband_stop(struct smmband *mb, int nthreads) {
+	int i;
+	pthread_mutex_lock(&mb->lock);
+	mb->quit = 1;
+	pthread_cond_broadcast(&mb->start);
+	pthread_mutex_unlock(&mb->lock);
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(mb->threads[i], NULL);
+	}
+}
+
+int smmband_init(struct smmband *mb, float bw, int blocklen, int nthreads,
+		 smmband_fn *fn, void *arg) {
+	int i;
+	float f;
+	if (!(bw > 0.0f)) {
+		return -1;
+	}
+	mb->nbands = 1;
+	for (f = bw; f < 0.5f; f += bw) {
+		mb->nbands++;
+	}
+	mb->blocklen = blocklen;
+	mb->fn = fn;
+	mb->arg = arg;
+	mb->nthreads = nthreads;
+	mb->gen = 0;
+	mb->next = mb->nbands;
+	mb->remaining = 0;
+	mb->n = 0;
+	mb->quit = 0;
+	mb->w_2 = malloc(sizeof(float) * mb->nbands);
+	if (mb->w_2 == NULL) {
+		goto undo0;
+	}
+	for (i = 0, f = bw; i < mb->nbands - 1; f += bw, i++) {
+		mb->w_2[i] = smff2w_2(f);
+	}
+	mb->u = calloc(mb->nbands, sizeof(float) * 6);
+	if (mb->u == NULL) {
+		goto undo1;
+	}
+	mb->ap = calloc(mb->nbands * mb->nbands, sizeof(float) * 2);
+	if (mb->ap == NULL) {
+		goto undo2;
+	}
+	mb->x = malloc(sizeof(float) * mb->nbands * blocklen);
+	if (mb->x == NULL) {
+		goto undo3;
+	}
+	mb->threads = malloc(sizeof(pthread_t) * (nthreads > 0 ? nthreads : 1));
+	if (mb->threads == NULL) {
+		goto undo4;
+	}
+	if (pthread_mutex_init(&mb->lock, NULL) != 0) {
+		goto undo5;
+	}
+	if (pthread_cond_init(&mb->start, NULL) != 0) {
+		goto undo6;
+	}
+	if (pthread_cond_init(&mb->done, NULL) != 0) {
+		goto undo7;
+	}
+	for (i = 0; i < nthreads; i++) {
+		if (pthread_create(&mb->threads[i], NULL,
+				   smmband_thread, mb) != 0) {
+			smmband_stop(mb, i);
+			goto undo8;
+		}
+	}
+	return 0;
+
+undo8:
+	pthread_cond_destroy(&mb->done);
+undo7:
+	pthread_cond_destroy(&mb->start);
+undo6:
+	pthread_mutex_destroy(&mb->lock);
+undo5:
+	free(mb->threads);
+undo4:
+	free(mb->x);
+undo3:
+	free(mb->ap);
+undo2:
+	free(mb->u);
+undo1:
+	free(mb->w_2);
+undo0:
+	return -1;
+}
+
+void smmband_destroy(struct smmband *mb) {
+	smmband_stop(mb, mb->nthreads);
+	pthread_cond_destroy(&mb->done);
+	pthread_cond_destroy(&mb->start);
+	pthread_mutex_destroy(&mb->lock);
+	free(mb->threads);
+	free(mb->x);
+	free(mb->ap);
+	free(mb->u);
+	free(mb->w_2);
+}
+
+void smmband(struct smmband *mb, int n, float *y, float *x) {
+	int i, j, m, len;
+	float *b;
+	len = mb->blocklen;
+	for (; n > 0; n -= m, x += m, y += m) {
+		m = n < len ? n : len;
+		/* split, band-major, as smf4split() */
+		memcpy(mb->x, x, sizeof(float) * m);
+		for (j = 0; j < mb->nbands - 1; j++) {
+			smf4linkwitz_riley(mb->u + 6 * j, m, mb->x + j * len,
+					   mb->x + (j + 1) * len,
+					   mb->x + j * len, mb->w_2[j]);
+		}
+		pthread_mutex_lock(&mb->lock);
+		mb->n = m;
+		mb->next = 0;
+		mb->remaining = mb->nbands;
+		mb->gen++;
+		pthread_cond_broadcast(&mb->start);
+		pthread_mutex_unlock(&mb->lock);
+		smmband_work(mb);
+		pthread_mutex_lock(&mb->lock);
+		while (mb->remaining > 0) {
+			pthread_cond_wait(&mb->done, &mb->lock);
+		}
+		pthread_mutex_unlock(&mb->lock);
+		memcpy(y, mb->x, sizeof(float) * m);
+		for (j = 1; j < mb->nbands; j++) {
+			b = mb->x + j * len;
+			for (i = 0; i < m; i++) {
+				y[i] += b[i];
+			}
+		}
+	}
+}
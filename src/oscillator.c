@@ -28,3 +28,12 @@ int smosc_init(struct smosc *osc) {
 void smosc_destroy(struct smosc *osc __attribute__((unused))) {
 	/* Do nothing */
 }
+
+int smphasor_init(struct smphasor *ph) {
+	smphasor_set_phase(ph, (smrand_uniformv() + 1.0f) / 2.0f);
+	return 0;
+}
+
+void smphasor_destroy(struct smphasor *ph __attribute__((unused))) {
+	/* Do nothing */
+}
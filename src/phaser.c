@@ -0,0 +1,99 @@
+/*
+ * phaser.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/vector.h"
+#include "sonicmaths/filter-bank.h"
+#include "sonicmaths/phaser.h"
+
+#define SMPHASER_NGROUPS(nchannels) (((nchannels) + SMV_WIDTH - 1) / SMV_WIDTH)
+
+int smphaser_init(struct smphaser *ph, int nchannels, int nstages) {
+	size_t size;
+	if (nstages < 1 || nstages > SMPHASER_MAXSTAGES) {
+		return -1;
+	}
+	ph->nchannels = nchannels;
+	ph->nstages = nstages;
+	size = sizeof(smvf) * nstages * SMPHASER_NGROUPS(nchannels);
+	ph->u = aligned_alloc(sizeof(smvf), size);
+	if (ph->u == NULL) {
+		return -1;
+	}
+	memset(ph->u, 0, size);
+	return 0;
+}
+
+void smphaser_destroy(struct smphaser *ph) {
+	free(ph->u);
+}
+
+static void smphaser_kernel(smvf *u, int nstages, int n, float *y,
+			    float *x, float *w) {
+	int i, k;
+	smvf _x, w_2, g, t1, t2;
+	for (i = 0; i < n; i++) {
+		_x = smvload(x + i * SMV_WIDTH);
+		w_2 = smvload(w + i * SMV_WIDTH);
+		g = 1.0f / (1.0f + w_2);
+		for (k = 0; k < nstages; k++) {
+			t1 = (_x - u[k]) * g;
+			t2 = u[k] + w_2 * t1;
+			u[k] = smvfpnorm(w_2 * t1 + t2);
+			_x = t2 - t1;
+		}
+		smvstore(y + i * SMV_WIDTH, _x);
+	}
+}
+
+void smphaser(struct smphaser *ph, int n, float **y, float **x, float **f) {
+	int i, m, l, c, nc, ns, cst[SMV_WIDTH];
+	float *gu;
+	smvf u[SMPHASER_MAXSTAGES];
+	float px[SMV_BLOCK * SMV_WIDTH];
+	float pw[SMV_BLOCK * SMV_WIDTH];
+	if (n <= 0) {
+		return;
+	}
+	ns = ph->nstages;
+	for (c = 0; c < ph->nchannels; c += SMV_WIDTH) {
+		nc = ph->nchannels - c;
+		if (nc > SMV_WIDTH) {
+			nc = SMV_WIDTH;
+		}
+		gu = ph->u + c * ns;
+		memcpy(u, gu, sizeof(smvf) * ns);
+		for (i = 0; i < n; i += m) {
+			m = n - i < SMV_BLOCK ? n - i : SMV_BLOCK;
+			smvinterleave(SMV_WIDTH, m, px, x + c, nc, i, 0.0f);
+			smvinterleave(SMV_WIDTH, m, pw, f + c, nc, i,
+				      SMF_FMIN);
+			for (l = 0; l < SMV_WIDTH; l++) {
+				cst[l] = l >= nc || smisconst(m, f[c + l] + i);
+			}
+			smfbank_prewarp(m, pw, cst);
+			smphaser_kernel(u, ns, m, px, px, pw);
+			smvdeinterleave(SMV_WIDTH, m, y + c, nc, i, px);
+		}
+		memcpy(gu, u, sizeof(smvf) * ns);
+		smfprepair(gu, ns * SMV_WIDTH);
+	}
+}
@@ -18,79 +18,219 @@
  * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "sonicmaths/math.h"
+#include "sonicmaths/vector.h"
 #include "sonicmaths/random.h"
 #include "sonicmaths/reverb.h"
 
+/* samples processed at a time */
+#define SMVERB_BLOCK 64
+
 int smverb_init(struct smverb *verb, int delaylen, int ndelays) {
-	int i;
+	int j;
+	size_t size;
 	verb->ndelays = ndelays;
 	verb->delaylen = delaylen;
-	verb->delays = malloc(sizeof(struct smverb_delay) * ndelays);
-	if (verb->delays == NULL) {
-		return -1;
-	}
-	verb->tdist = malloc(sizeof(float) * ndelays);
+	/* keep each line aligned */
+	verb->stride = (delaylen + SMV_WIDTH - 1) / SMV_WIDTH * SMV_WIDTH;
+	verb->i = 0;
+	verb->tdist = aligned_alloc(sizeof(smvf),
+				    sizeof(smvf) * ((ndelays + SMV_WIDTH - 1)
+						    / SMV_WIDTH));
 	if (verb->tdist == NULL) {
-		free(verb->delays);
-		return -1;
-	}
-	for (i = 0; i < ndelays; i++) {
-		verb->delays[i].i = 0;
-		verb->delays[i].x = calloc(delaylen, sizeof(float));
-		if (verb->delays[i].x == NULL) {
-			while (i--) {
-				free(verb->delays[i].x);
-			}
-			free(verb->delays);
-			free(verb->tdist);
-			return -1;
-		}
-		verb->tdist[i] = smrand_gaussianv();
+		goto undo0;
+	}
+	size = sizeof(float) * (size_t) verb->stride * (size_t) ndelays;
+	verb->x = aligned_alloc(sizeof(smvf), size > 0 ? size : sizeof(smvf));
+	if (verb->x == NULL) {
+		goto undo1;
+	}
+	memset(verb->x, 0, size);
+	for (j = 0; j < ndelays; j++) {
+		verb->tdist[j] = smrand_gaussianv();
 	}
 	return 0;
+undo1:
+	free(verb->tdist);
+undo0:
+	return -1;
 }
 
 void smverb_destroy(struct smverb *verb) {
-	int i;
-	for (i = 0; i < verb->ndelays; i++) {
-		free(verb->delays[i].x);
-	}
-	free(verb->delays);
+	free(verb->x);
 	free(verb->tdist);
 }
 
+/*
+ * m samples of line x, of length dlen, at the constant delay tn - tf,
+ * tn being whole; the first is read with the write position at xi
+ */
+static void smverb_read_const(const float *x, int dlen, int xi, int m,
+			      int tn, float tf, float *r) {
+	int i, k, ti;
+	ti = (xi - tn) % dlen;
+	if (ti < 0) {
+		ti += dlen;
+	}
+	/* the samples before either point read wraps */
+	k = dlen - 1 - ti;
+	if (k > m) {
+		k = m;
+	}
+	if (tf == 0.0f) {
+		/* whole delays need no interpolation */
+		memcpy(r, x + ti, sizeof(float) * (k < m ? k + 1 : k));
+		if (k + 1 < m) {
+			memcpy(r + k + 1, x, sizeof(float) * (m - k - 1));
+		}
+		return;
+	}
+	for (i = 0; i < k; i++) {
+		r[i] = x[ti + i] + tf * (x[ti + i + 1] - x[ti + i]);
+	}
+	if (k < m) {
+		r[k] = x[dlen - 1] + tf * (x[0] - x[dlen - 1]);
+		for (i = k + 1; i < m; i++) {
+			ti = i - k - 1;
+			r[i] = x[ti] + tf * (x[ti + 1] - x[ti]);
+		}
+	}
+}
+
+/* the same as smverb_read_const(), for the delays d */
+static void smverb_read(const float *x, int dlen, int xi, int m,
+			const float *d, float *r) {
+	int i, l, ti, tj, ni;
+	float tf, tn;
+	smvi iota, vi, vj;
+	smvf vt, vn, a0, a1;
+	for (l = 0; l < SMV_WIDTH; l++) {
+		iota[l] = l;
+	}
+	a0 = a1 = smvdup(0.0f);
+	for (i = 0; i + SMV_WIDTH <= m; i += SMV_WIDTH) {
+		vt = smvload(d + i);
+		vn = -smvfloor(-vt);
+		vt = vn - vt;
+		vi = xi + i + iota - __builtin_convertvector(vn, smvi);
+		vi += (vi < 0) & dlen;
+		vi -= (vi >= dlen) & dlen;
+		vj = vi + 1;
+		vj &= vj != dlen;
+		for (l = 0; l < SMV_WIDTH; l++) {
+			a0[l] = x[vi[l]];
+			a1[l] = x[vj[l]];
+		}
+		smvstore(r + i, a0 + vt * (a1 - a0));
+	}
+	for (; i < m; i++) {
+		/* ceilf(), without the call */
+		tf = d[i];
+		ni = (int) tf;
+		ni += (float) ni < tf;
+		tn = (float) ni;
+		tf = tn - tf;
+		ti = xi + i - ni;
+		ti += ti < 0 ? dlen : ti >= dlen ? -dlen : 0;
+		tj = ti + 1 == dlen ? 0 : ti + 1;
+		r[i] = x[ti] + tf * (x[tj] - x[ti]);
+	}
+}
+
+/*
+ * m samples through the delays, m being no more than the shortest delay
+ * less one; d holds the delays of each line, SMVERB_BLOCK apart, and r
+ * and fb are scratch
+ */
+static void smverb_run(struct smverb *verb, int m, float *y, float *x,
+		       float *t, float *tdev, float *g, float *d, float *r,
+		       float *fb) {
+	int i, j, k, N, xi, dlen, cst;
+	float tn, c;
+	float *line, *rj;
+
+	N = verb->ndelays;
+	dlen = verb->delaylen;
+	xi = verb->i;
+	c = -2.0f / (float) N;
+
+	cst = smisconst(m, t) && smisconst(m, tdev);
+	for (j = 0; j < N; j++) {
+		line = verb->x + j * verb->stride;
+		if (cst) {
+			tn = ceilf(d[j * SMVERB_BLOCK]);
+			smverb_read_const(line, dlen, xi, m, (int) tn,
+					  tn - d[j * SMVERB_BLOCK],
+					  r + j * SMVERB_BLOCK);
+		} else {
+			smverb_read(line, dlen, xi, m, d + j * SMVERB_BLOCK,
+				    r + j * SMVERB_BLOCK);
+		}
+	}
+	/* the Householder feedback, a sample at a time across the run */
+	for (i = 0; i < m; i++) {
+		y[i] = 0.0f;
+	}
+	for (j = 0; j < N; j++) {
+		rj = r + j * SMVERB_BLOCK;
+		for (i = 0; i < m; i++) {
+			y[i] += rj[i];
+		}
+	}
+	for (i = 0; i < m; i++) {
+		fb[i] = c * g[i] * y[i];
+	}
+	/* write the run, in at most two pieces */
+	k = dlen - xi < m ? dlen - xi : m;
+	for (j = 0; j < N; j++) {
+		line = verb->x + j * verb->stride;
+		rj = r + j * SMVERB_BLOCK;
+		for (i = 0; i < k; i++) {
+			line[xi + i] = SMFPNORM(x[i] + g[i] * rj[i] + fb[i]);
+		}
+		for (; i < m; i++) {
+			line[xi + i - dlen] = SMFPNORM(x[i] + g[i] * rj[i]
+						       + fb[i]);
+		}
+		/* repair what was written */
+		smfprepair(line + xi, k);
+		smfprepair(line, m - k);
+	}
+	verb->i = xi + m < dlen ? xi + m : xi + m - dlen;
+}
+
 void smverb(struct smverb *verb, int n, float *y, float *x, float *t,
 	    float *tdev, float *g) {
-	int i, j, N, xi, ti, dlen;
-	float _y, yj, fb, tf, tn, fN;
+	int i, j, m, o, p, K, M, N;
+	float dmin;
 
 	N = verb->ndelays;
-	fN = (float) N;
-	dlen = verb->delaylen;
 
-	for (i = 0; i < n; i++) {
-		_y = 0;
+	float d[N * SMVERB_BLOCK], r[N * SMVERB_BLOCK], fb[SMVERB_BLOCK];
+	for (o = 0; o < n; o += M) {
+		M = n - o < SMVERB_BLOCK ? n - o : SMVERB_BLOCK;
+		dmin = (float) verb->delaylen;
 		for (j = 0; j < N; j++) {
-			xi = verb->delays[j].i;
-			tf = t[i] + tdev[i] * verb->tdist[j];
-			tn = ceilf(tf);
-			tf = tn - tf;
-			ti = ((xi + dlen) - (int) tn) % dlen;
-			yj = verb->delays[j].x[ti];
-			yj += tf * (verb->delays[j].x[(ti + 1) % dlen] - yj);
-			_y += yj;
-			verb->delays[j].x[xi] = x[i] + g[i] * yj;
+			for (i = 0; i < M; i++) {
+				d[j * SMVERB_BLOCK + i] = t[o + i]
+					+ tdev[o + i] * verb->tdist[j];
+				if (d[j * SMVERB_BLOCK + i] < dmin) {
+					dmin = d[j * SMVERB_BLOCK + i];
+				}
+			}
 		}
-		fb = -2 * g[i] * _y / fN;
-		for (j = 0; j < N; j++) {
-			xi = verb->delays[j].i;
-			verb->delays[j].x[xi]
-				= SMFPNORM(verb->delays[j].x[xi] + fb);
-			verb->delays[j].i = (xi + 1) % dlen;
+		/* every read of a run comes before every write, so a run is
+		 * only as long as the shortest delay allows */
+		K = (int) ceilf(dmin) - 1;
+		if (K < 1) {
+			K = 1;
+		}
+		for (p = 0; p < M; p += m) {
+			m = M - p < K ? M - p : K;
+			smverb_run(verb, m, y + o + p, x + o + p, t + o + p,
+				   tdev + o + p, g + o + p, d + p, r, fb);
 		}
-		y[i] = _y;
 	}
 }
-
@@ -0,0 +1,178 @@
+/*
+ * strings.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/vector.h"
+#include "sonicmaths/fastmath.h"
+#include "sonicmaths/strings.h"
+
+#define SMSTRINGS_NPAD(n) (((n) + SMV_WIDTH - 1) / SMV_WIDTH * SMV_WIDTH)
+/* the largest allpass pole radius that smstrings_set() will tune with */
+#define SMSTRINGS_MAXETA 0.9f
+
+int smstrings_init(struct smstrings *sb, int nstrings, int maxdelay) {
+	int k, np;
+	float *p;
+	np = SMSTRINGS_NPAD(nstrings);
+	sb->nstrings = nstrings;
+	/* room for the whole delay and the allpass's fraction */
+	for (sb->len = 4; sb->len < maxdelay + 2; sb->len <<= 1) {
+		/* grow */
+	}
+	sb->i = 0;
+	sb->x = aligned_alloc(sizeof(smvf), sizeof(float) * np * sb->len);
+	if (sb->x == NULL) {
+		goto undo0;
+	}
+	sb->n = aligned_alloc(sizeof(smvf), sizeof(int) * np);
+	if (sb->n == NULL) {
+		goto undo1;
+	}
+	p = aligned_alloc(sizeof(smvf), sizeof(float) * 6 * np);
+	if (p == NULL) {
+		goto undo2;
+	}
+	sb->eta = p;
+	sb->c = p + np;
+	sb->rho = p + 2 * np;
+	sb->ax1 = p + 3 * np;
+	sb->ay1 = p + 4 * np;
+	sb->ly1 = p + 5 * np;
+	memset(sb->x, 0, sizeof(float) * np * sb->len);
+	memset(p, 0, sizeof(float) * 6 * np);
+	for (k = 0; k < np; k++) {
+		smstrings_set(sb, k, 0.01f, 1000.0f, 0.5f);
+	}
+	return 0;
+undo2:
+	free(sb->n);
+undo1:
+	free(sb->x);
+undo0:
+	return -1;
+}
+
+void smstrings_destroy(struct smstrings *sb) {
+	free(sb->eta);
+	free(sb->n);
+	free(sb->x);
+}
+
+void smstrings_set(struct smstrings *sb, int k, float f, float decay,
+		   float brightness) {
+	int n;
+	float d, c, frac, w, s, eta;
+	c = brightness > 1.0f ? 1.0f : brightness < 0.01f ? 0.01f
+		: brightness;
+	/* the loop delay, less the phase delay of the lowpass at f, with the
+	 * allpass taking between 0.5 and 1.5 samples of it */
+	w = 2.0f * (float) M_PI * f;
+	d = w > 0.0f ? 1.0f / f - smatanv((1.0f - c) * smsinv(w)
+					  / (1.0f - (1.0f - c) * smcosv(w))) / w
+		: INFINITY;
+	if (!(d >= 1.5f)) {
+		d = 1.5f;
+	} else if (d > (float) (sb->len - 2)) {
+		d = (float) (sb->len - 2);
+	}
+	n = (int) (d - 0.5f);
+	frac = d - (float) n;
+	sb->n[k] = n;
+	/* the allpass coefficient with a phase delay of frac at f; near
+	 * Nyquist that would put the pole on or past the unit circle, so fall
+	 * back to a delay of frac at DC */
+	eta = smsinv((1.0f - frac) * w / 2.0f);
+	s = smsinv((1.0f + frac) * w / 2.0f);
+	sb->eta[k] = fabsf(eta) < SMSTRINGS_MAXETA * s ? eta / s
+		: (1.0f - frac) / (1.0f + frac);
+	sb->c[k] = c;
+	sb->rho[k] = decay > 0.0f ? smexpv(-1.0f / (f * decay)) : 0.0f;
+}
+
+void smstrings_reset(struct smstrings *sb, int k) {
+	int j, g, l;
+	g = k / SMV_WIDTH;
+	l = k % SMV_WIDTH;
+	for (j = 0; j < sb->len; j++) {
+		sb->x[(g * sb->len + j) * SMV_WIDTH + l] = 0.0f;
+	}
+	sb->ax1[k] = 0.0f;
+	sb->ay1[k] = 0.0f;
+	sb->ly1[k] = 0.0f;
+}
+
+static void smstrings_kernel(struct smstrings *sb, int g, int n, float *y,
+			     float *x) {
+	int i, j, l, di, mask, k;
+	int dn[SMV_WIDTH];
+	float *line;
+	smvf r, eta, c, rho, ax1, ay1, ly1, _y;
+	k = g * SMV_WIDTH;
+	line = sb->x + k * sb->len;
+	mask = sb->len - 1;
+	memcpy(dn, sb->n + k, sizeof(dn));
+	eta = smvload(sb->eta + k);
+	c = smvload(sb->c + k);
+	rho = smvload(sb->rho + k);
+	ax1 = smvload(sb->ax1 + k);
+	ay1 = smvload(sb->ay1 + k);
+	ly1 = smvload(sb->ly1 + k);
+	r = smvdup(0.0f);
+	di = sb->i;
+	for (i = 0; i < n; i++) {
+		for (l = 0; l < SMV_WIDTH; l++) {
+			j = (di - dn[l]) & mask;
+			r[l] = line[j * SMV_WIDTH + l];
+		}
+		ay1 = eta * (r - ay1) + ax1;
+		ax1 = r;
+		ly1 += c * (ay1 - ly1);
+		_y = rho * ly1 + smvload(x + i * SMV_WIDTH);
+		smvstore(line + di * SMV_WIDTH, _y);
+		smvstore(y + i * SMV_WIDTH, _y);
+		di = (di + 1) & mask;
+	}
+	smvstore(sb->ax1 + k, ax1);
+	smvstore(sb->ay1 + k, ay1);
+	smvstore(sb->ly1 + k, ly1);
+	smfprepair(sb->ay1 + k, SMV_WIDTH);
+	smfprepair(sb->ly1 + k, SMV_WIDTH);
+}
+
+void smstrings(struct smstrings *sb, int n, float **y, float **x) {
+	int i, m, c, nc;
+	float px[SMV_BLOCK * SMV_WIDTH];
+	for (i = 0; i < n; i += m) {
+		m = n - i < SMV_BLOCK ? n - i : SMV_BLOCK;
+		for (c = 0; c < sb->nstrings; c += SMV_WIDTH) {
+			nc = sb->nstrings - c;
+			if (nc > SMV_WIDTH) {
+				nc = SMV_WIDTH;
+			}
+			smvinterleave(SMV_WIDTH, m, px, x + c, nc, i, 0.0f);
+			smstrings_kernel(sb, c / SMV_WIDTH, m, px, px);
+			smvdeinterleave(SMV_WIDTH, m, y + c, nc, i, px);
+		}
+		/* every string has moved on through its delay */
+		sb->i = (sb->i + m) & (sb->len - 1);
+	}
+}
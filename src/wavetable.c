@@ -0,0 +1,282 @@
+/*
+ * wavetable.c
+ * 
+ * Copyright 2015 Evan Buswell
+ * 
+ * This file is part of Sonic Maths.
+ * 
+ * Sonic Maths is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, version 2.
+ * 
+ * Sonic Maths is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with Sonic Maths.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sonicmaths/math.h"
+#include "sonicmaths/oscillator.h"
+#include "sonicmaths/wavetable.h"
+
+/* the guard points before and after each level */
+#define SMWAVETABLE_PRE 1
+#define SMWAVETABLE_POST 2
+#define SMWAVETABLE_STRIDE(len) ((len) + SMWAVETABLE_PRE + SMWAVETABLE_POST)
+
+#define SMWAVETABLE_MAGIC "SMWAVE1"
+
+/* the cache file: this header, then the levels */
+struct smwavetable_header {
+	char magic[8];
+	uint32_t len;
+	uint32_t nlevels;
+	uint64_t hash;
+	char pad[40];
+};
+
+/* FNV-1a of the cycle, to tell whether a cache file is for it */
+static uint64_t smwavetable_hash(int len, const float *cycle) {
+	size_t i;
+	uint64_t h;
+	const unsigned char *p;
+	p = (const unsigned char *) cycle;
+	h = 14695981039346656037ULL;
+	for (i = 0; i < sizeof(float) * (size_t) len; i++) {
+		h ^= p[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+/* resynthesize each level from the harmonics of the cycle */
+static int smwavetable_build(int len, int nlevels, const float *cycle,
+			     float *data) {
+	int i, k, l, nh;
+	size_t m, q;
+	double *s, *a, *b, x;
+	float *y;
+	nh = len / 4;
+	s = malloc(sizeof(double) * (size_t) (len + 2 * (nh + 1)));
+	if (s == NULL) {
+		return -1;
+	}
+	a = s + len;
+	b = a + nh + 1;
+	for (i = 0; i < len; i++) {
+		s[i] = sin(2 * M_PI * (double) i / (double) len);
+	}
+	/* sin(2 pi k i / len) is s[k i mod len], and the cosine is q, a
+	 * quarter cycle, on */
+	q = (size_t) len / 4;
+	for (k = 0; k <= nh; k++) {
+		a[k] = 0.0;
+		b[k] = 0.0;
+		for (i = 0; i < len; i++) {
+			m = ((size_t) k * i) & (len - 1);
+			a[k] += (double) cycle[i] * s[(m + q) & (len - 1)];
+			b[k] += (double) cycle[i] * s[m];
+		}
+		a[k] *= 2.0 / (double) len;
+		b[k] *= 2.0 / (double) len;
+	}
+	a[0] /= 2.0;
+	for (l = 0; l < nlevels; l++) {
+		y = data + l * SMWAVETABLE_STRIDE(len) + SMWAVETABLE_PRE;
+		for (i = 0; i < len; i++) {
+			x = a[0];
+			for (k = 1; k <= nh >> l; k++) {
+				m = ((size_t) k * i) & (len - 1);
+				x += a[k] * s[(m + q) & (len - 1)]
+					+ b[k] * s[m];
+			}
+			y[i] = (float) x;
+		}
+		y[-1] = y[len - 1];
+		y[len] = y[0];
+		y[len + 1] = y[1];
+	}
+	free(s);
+	return 0;
+}
+
+/* map the cache file, if it holds the levels for this cycle */
+static int smwavetable_load(struct smwavetable *wt, const char *cachepath,
+			    uint64_t hash) {
+	int fd;
+	void *map;
+	struct stat st;
+	const struct smwavetable_header *h;
+	fd = open(cachepath, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size != wt->mapsize) {
+		close(fd);
+		return -1;
+	}
+	map = mmap(NULL, wt->mapsize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return -1;
+	}
+	h = map;
+	if (memcmp(h->magic, SMWAVETABLE_MAGIC, sizeof(h->magic)) != 0
+	    || h->len != (uint32_t) wt->len
+	    || h->nlevels != (uint32_t) wt->nlevels || h->hash != hash) {
+		munmap(map, wt->mapsize);
+		return -1;
+	}
+	wt->map = map;
+	return 0;
+}
+
+/* write the levels to the cache file, by way of a temporary file so that
+ * no reader sees it half written */
+static int smwavetable_save(struct smwavetable *wt, const char *cachepath) {
+	int fd, r;
+	size_t len;
+	ssize_t w;
+	char *tmp;
+	const char *p;
+	len = strlen(cachepath) + 32;
+	tmp = malloc(len);
+	if (tmp == NULL) {
+		return -1;
+	}
+	snprintf(tmp, len, "%s.%ld.tmp", cachepath, (long) getpid());
+	fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, 0644);
+	if (fd < 0) {
+		goto undo0;
+	}
+	p = wt->map;
+	for (len = 0; len < wt->mapsize; len += (size_t) w) {
+		w = write(fd, p + len, wt->mapsize - len);
+		if (w <= 0) {
+			goto undo1;
+		}
+	}
+	if (close(fd) != 0) {
+		goto undo2;
+	}
+	r = rename(tmp, cachepath);
+	if (r != 0) {
+		goto undo2;
+	}
+	free(tmp);
+	return 0;
+undo1:
+	close(fd);
+undo2:
+	unlink(tmp);
+undo0:
+	free(tmp);
+	return -1;
+}
+
+int smwavetable_init(struct smwavetable *wt, int len, const float *cycle,
+		     const char *cachepath) {
+	int l;
+	uint64_t hash;
+	void *map;
+	struct smwavetable_header *h;
+	if (len < 8 || (len & (len - 1)) != 0) {
+		return -1;
+	}
+	wt->len = len;
+	for (l = 0; len >> (l + 2) > 0; l++) {
+		/* count */
+	}
+	wt->nlevels = l;
+	wt->mapsize = sizeof(struct smwavetable_header) + sizeof(float)
+		* (size_t) (wt->nlevels * SMWAVETABLE_STRIDE(len));
+	hash = smwavetable_hash(len, cycle);
+	if (cachepath == NULL || smwavetable_load(wt, cachepath, hash) != 0) {
+		wt->map = mmap(NULL, wt->mapsize, PROT_READ | PROT_WRITE,
+			       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (wt->map == MAP_FAILED) {
+			return -1;
+		}
+		h = wt->map;
+		memcpy(h->magic, SMWAVETABLE_MAGIC, sizeof(h->magic));
+		h->len = (uint32_t) len;
+		h->nlevels = (uint32_t) wt->nlevels;
+		h->hash = hash;
+		if (smwavetable_build(len, wt->nlevels, cycle,
+				      (float *) (h + 1)) != 0
+		    || mprotect(wt->map, wt->mapsize, PROT_READ) != 0) {
+			munmap(wt->map, wt->mapsize);
+			return -1;
+		}
+		/* once saved, read the file's pages, which other processes
+		 * share */
+		if (cachepath != NULL && smwavetable_save(wt, cachepath) == 0) {
+			map = wt->map;
+			if (smwavetable_load(wt, cachepath, hash) == 0) {
+				munmap(map, wt->mapsize);
+			}
+		}
+	}
+	wt->data = (const float *) ((const struct smwavetable_header *) wt->map
+				    + 1);
+	return 0;
+}
+
+void smwavetable_destroy(struct smwavetable *wt) {
+	munmap(wt->map, wt->mapsize);
+}
+
+void smwavetable(const struct smwavetable *wt, struct smosc *osc, int n,
+		 float *y, float *f, float *phi) {
+	int i, j, l, len;
+	uint32_t e;
+	double t, p;
+	float u, x0, x1, x2, x3, h, af;
+	const float *tab;
+	len = wt->len;
+	h = (float) (len / 2);
+	t = osc->t;
+	for (i = 0; i < n; i++) {
+		/* level l keeps len / 2^(l + 2) harmonics, which are below
+		 * Nyquist while |f| len / 2 < 2^l; l is the exponent as
+		 * frexpf() would give it */
+		af = fabsf(f[i]) * h;
+		memcpy(&e, &af, sizeof(e));
+		l = (int) (e >> 23) - 126;
+		if (l < 0) {
+			l = 0;
+		} else if (l >= wt->nlevels) {
+			l = wt->nlevels - 1;
+		}
+		tab = wt->data + l * SMWAVETABLE_STRIDE(len) + SMWAVETABLE_PRE;
+		p = (t + (double) phi[i]) * (double) len;
+		j = (int) p;
+		if ((double) j > p) {
+			j--;
+		}
+		u = (float) (p - (double) j);
+		j &= len - 1;
+		x0 = tab[j - 1];
+		x1 = tab[j];
+		x2 = tab[j + 1];
+		x3 = tab[j + 2];
+		y[i] = x1 + u * (0.5f * (x2 - x0)
+				 + u * (x0 - 2.5f * x1 + 2.0f * x2 - 0.5f * x3
+					+ u * (0.5f * (x3 - x0)
+					       + 1.5f * (x1 - x2))));
+		t += (double) f[i];
+		t -= floor(t);
+	}
+	osc->t = isfinite(t) ? t : 0.0;
+}